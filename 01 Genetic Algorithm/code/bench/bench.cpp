@@ -0,0 +1,529 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <chrono>
+
+#include "../rng.h"
+#include "../problem.h"
+#include "../bitpack.h"
+#include "../geneticalgorithm.h"
+#include "../graphio.h"
+
+/*
+** benchmark of the GA kernels. it is a program of its own, build it from the code directory with the
+** sources of the GA but without main.cpp, for example:
+**	g++ -std=c++17 -O2 -pthread bench/bench.cpp $(ls *.cpp | grep -v main.cpp) -o bench
+** usage: bench [json file] [quick] [graph=path ...]
+** results are written as JSON to json file, or to stdout if it is not given or is "-". progress goes to stderr.
+** quick (any value) runs a smaller sweep and one instance per end-to-end case.
+** each graph=path adds end-to-end runs on the graph of a file, a fixed public instance for example. a path ending
+** with ".graph" is a binary graph file which is mapped, anything else is read as DIMACS .col (see graphio.h).
+*/
+
+#define BENCH_SEED	20170109UL	/*all graphs, solutions and runs are drawn from this seed*/
+#define BENCH_SAMPLES	5	/*number of timed samples of each case, the median is reported*/
+#define BENCH_SAMPLE_SECONDS	0.02	/*a sample repeats the operation until it takes at least this long*/
+#define BENCH_POP_SIZE	DEFAULT_POP_SIZE	/*population size of the kernel cases*/
+#define BENCH_INSTANCES	3	/*number of graphs of each end-to-end case*/
+#define BENCH_JSON_VERSION	1	/*version of the JSON layout*/
+
+/*node numbers and densities of the kernel sweep*/
+static int const sweep_nodes[] = { 30, 90, 300, 900 };
+static float const sweep_ds[] = { 2.0f, 5.0f, 10.0f };
+
+/*instance set of the end-to-end runs*/
+static int const solve_nodes[] = { 60, 90 };
+static float const solve_ds[] = { 1.5f, 2.0f, 3.0f };
+
+/*everything an operation under test works on*/
+typedef struct Bench_State {
+	GA_Config config;	/*the defaults, the crossover cases change cross_method*/
+	Graph *graph;
+	Population *parents;
+	Population *children;
+	Conflict_Infor *infor;
+	Rng *rng;
+	int node_number;
+	float d;
+	Alias_Table roulette;	/*roulette of parents*/
+	int *conflicts;	/*conflict links of each parent, written by the bitsliced cases*/
+	double sink;	/*results of the operations are added here, so the compiler cannot drop them*/
+} Bench_State;
+
+/*an operation under test*/
+typedef void(*Bench_Op)(Bench_State *state);
+
+/*JSON output and its separators*/
+typedef struct Bench_Output {
+	FILE *file;
+	int first;	/*no record was written to the current array yet*/
+} Bench_Output;
+
+/*monotonic time in seconds*/
+static double now_seconds(void)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*compare doubles for qsort, the smaller first*/
+static int double_compare(void const *a, void const *b)
+{
+	double x = *(double const *)a;
+	double y = *(double const *)b;
+
+	return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/*
+** time an operation. the number of repetitions is doubled until a sample takes BENCH_SAMPLE_SECONDS,
+** then BENCH_SAMPLES samples are taken. return the median nanoseconds per operation, the fastest one is put in min_ns.
+*/
+static double time_op(Bench_Op op, Bench_State *state, long *reps, double *min_ns)
+{
+	double samples[BENCH_SAMPLES];
+	long count = 1;
+
+	while (1) {
+		double start = now_seconds();
+		for (long r = 0; r < count; r++) {
+			op(state);
+		}
+		if (now_seconds() - start >= BENCH_SAMPLE_SECONDS || count >= (1L << 30)) {
+			break;
+		}
+		count *= 2;
+	}
+
+	for (int s = 0; s < BENCH_SAMPLES; s++) {
+		double start = now_seconds();
+		for (long r = 0; r < count; r++) {
+			op(state);
+		}
+		samples[s] = (now_seconds() - start) * 1e9 / count;
+	}
+	qsort(samples, BENCH_SAMPLES, sizeof(double), double_compare);
+
+	*reps = count;
+	*min_ns = samples[0];
+	return samples[BENCH_SAMPLES / 2];
+}
+
+/*
+** the operations under test. population operations work on a whole generation,
+** the others on one solution or one call. crossover runs the pipeline of the crossover method in state->config.
+*/
+static void op_fitness(Bench_State *state)
+{
+	state->sink += fitness(state->graph, state->parents->chromos[0].solution);
+}
+
+static void op_population_fitness(Bench_State *state)
+{
+	for (int i = 0; i < state->parents->size; i++) {
+		state->sink += fitness(state->graph, state->parents->chromos[i].solution);
+	}
+}
+
+static void op_population_states(Bench_State *state)
+{
+	for (int i = 0; i < state->parents->size; i++) {
+		conflict_state_init(state->graph, state->parents->chromos[i].solution, &state->children->chromos[i].state);
+	}
+}
+
+static void op_slice_fitness(Bench_State *state)
+{
+	Population const *parents = state->parents;
+
+	slice_conflicts(parents->slice, state->graph, parents->genes, parents->size, state->conflicts, NULL, NULL);
+	state->sink += state->conflicts[0];
+}
+
+static void op_slice_states(Bench_State *state)
+{
+	Population const *parents = state->parents;
+
+	slice_conflicts(parents->slice, state->graph, parents->genes, parents->size, state->conflicts, state->children->node_conflicts, NULL);
+	state->sink += state->conflicts[0];
+}
+
+static void op_solution_conflict(Bench_State *state)
+{
+	state->sink += solution_conflict(state->graph, state->parents->chromos[0].solution, state->infor);
+}
+
+static void op_crossover(Bench_State *state)
+{
+	crossover(&state->config, state->parents, state->children, 0, state->parents->size / 2, &state->roulette, state->rng, NULL);
+}
+
+static void op_point_crossover(Bench_State *state)
+{
+	Population const *parents = state->parents;
+	Population *children = state->children;
+
+	for (int i = 0; i + 1 < parents->size; i += 2) {
+		point_crossover(parents->node_number / 2, parents->chromos[i].solution, parents->chromos[i + 1].solution,
+			children->chromos[i].solution, children->chromos[i + 1].solution, parents->node_number);
+	}
+}
+
+static void op_mask_crossover(Bench_State *state)
+{
+	Population const *parents = state->parents;
+	Population *children = state->children;
+
+	for (int i = 0; i + 1 < parents->size; i += 2) {
+		parents->cross->mask_crossover(children->masks, parents->chromos[i].solution, parents->chromos[i + 1].solution,
+			children->chromos[i].solution, children->chromos[i + 1].solution, parents->node_number);
+	}
+}
+
+static void op_mutation(Bench_State *state)
+{
+	mutation(state->children, 0, state->children->size, state->config.mutate_rate, state->rng);
+}
+
+static void op_tournament_selection(Bench_State *state)
+{
+	state->sink += tournament_selection(state->parents, state->config.k_candidate, state->rng);
+}
+
+static void op_roulette_selection(Bench_State *state)
+{
+	state->sink += roulette_selection(&state->roulette, state->rng);
+}
+
+static void op_roulette_table(Bench_State *state)
+{
+	alias_table_build(&state->roulette, state->parents->fitness, state->parents->size);
+}
+
+static void op_scaling(Bench_State *state)
+{
+	scaling(state->children);
+}
+
+static void op_generate_random_graph(Bench_State *state)
+{
+	generate_random_graph(state->graph, state->node_number, state->d, state->rng);
+}
+
+/*start a named JSON array*/
+static void begin_array(Bench_Output *out, char const *name, int first_member)
+{
+	fprintf(out->file, "%s\n  \"%s\": [", first_member ? "" : ",", name);
+	out->first = 1;
+}
+
+/*close a JSON array*/
+static void end_array(Bench_Output *out)
+{
+	fprintf(out->file, "\n  ]");
+}
+
+/*time an operation and write its record*/
+static void bench_case(Bench_Output *out, char const *name, char const *variant, int per_generation, Bench_Op op, Bench_State *state)
+{
+	long reps = 0;
+	double min_ns = 0.0;
+	double median_ns = time_op(op, state, &reps, &min_ns);
+
+	fprintf(out->file, "%s\n    { \"name\": \"%s\", \"variant\": \"%s\", \"n\": %d, \"d\": %.2f, \"unit\": \"%s\", "
+		"\"reps\": %ld, \"median_ns\": %.2f, \"min_ns\": %.2f }",
+		out->first ? "" : ",", name, variant, state->node_number, state->d, per_generation ? "generation" : "call",
+		reps, median_ns, min_ns);
+	out->first = 0;
+	fprintf(stderr, "  %-24s %-8s n = %4d d = %5.2f %14.1f ns\n", name, variant, state->node_number, state->d, median_ns);
+}
+
+/*run the kernel cases of one node number and density*/
+static void bench_kernels(Bench_Output *out, int node_number, float d, Rng *rng)
+{
+	Graph graph = {};
+	Graph scratch = {};
+	Population parents;
+	Population children;
+	Conflict_Infor infor;
+	Bench_State state;
+	char const *bit_names[] = { "portable", "popcnt", "avx2", "avx512" };
+	char const *cross_names[] = { "portable", "avx2", "avx512" };
+	char const *slice_names[] = { "portable", "avx2", "avx512" };
+
+	generate_random_graph(&graph, node_number, d, rng);
+	population_init(&parents, BENCH_POP_SIZE, node_number);
+	population_init(&children, BENCH_POP_SIZE, node_number);
+	initialize(&parents, &graph, rng);
+	initialize(&children, &graph, rng);
+	random_mask(children.masks, node_number, rng);
+	infor.conflict_nodes = (int *)calloc(node_number, sizeof(int));
+	infor.conflict_numbers = (int *)calloc(node_number, sizeof(int));
+	state.conflicts = (int *)calloc(parents.size, sizeof(int));
+	if (infor.conflict_nodes == NULL || infor.conflict_numbers == NULL || state.conflicts == NULL) {
+		printf("[BENCH.cpp--bench_kernels--ERROR] cannot allocate memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	ga_config_default(&state.config);
+	state.graph = &graph;
+	state.parents = &parents;
+	state.children = &children;
+	state.infor = &infor;
+	state.rng = rng;
+	state.node_number = node_number;
+	state.d = d;
+	alias_table_init(&state.roulette, parents.size);
+	alias_table_build(&state.roulette, parents.fitness, parents.size);
+	state.sink = 0.0;
+
+	/*
+	** fitness with the adjacency lists, and with the bitset adjacency and each popcount kernel this cpu supports.
+	*/
+	Bit_Kernels const *default_bits = graph.bit_kernels;
+	uint64_t *bit_rows = graph.bit_rows;
+	graph.bit_rows = NULL;
+	bench_case(out, "fitness", "csr", 0, op_fitness, &state);
+	graph.bit_rows = bit_rows;
+	if (graph.bit_rows == NULL) {
+		graph_build_bits(&graph);
+		default_bits = NULL;	/*the bitset adjacency is released again below*/
+	}
+	for (unsigned k = 0; k < sizeof bit_names / sizeof bit_names[0]; k++) {
+		if ((graph.bit_kernels = find_bit_kernels(bit_names[k])) != NULL) {
+			bench_case(out, "fitness", bit_names[k], 0, op_fitness, &state);
+		}
+	}
+	if (default_bits == NULL) {
+		graph_free_bits(&graph);
+	}
+	else {
+		graph.bit_kernels = default_bits;
+	}
+
+	bench_case(out, "solution_conflict", "csr", 0, op_solution_conflict, &state);
+
+	/*
+	** fitness and conflict states of the whole population, one solution at a time and bitsliced with each instruction set.
+	*/
+	bench_case(out, "population_fitness", "scalar", 1, op_population_fitness, &state);
+	bench_case(out, "population_states", "scalar", 1, op_population_states, &state);
+	for (unsigned k = 0; k < sizeof slice_names / sizeof slice_names[0]; k++) {
+		if ((parents.slice = find_slice_kernels(slice_names[k])) != NULL) {
+			bench_case(out, "population_fitness", slice_names[k], 1, op_slice_fitness, &state);
+			bench_case(out, "population_states", slice_names[k], 1, op_slice_states, &state);
+		}
+	}
+	parents.slice = select_slice_kernels(parents.size);
+
+	state.config.cross_method = 1;
+	bench_case(out, "crossover_point", "scalar", 1, op_crossover, &state);
+	state.config.cross_method = 2;
+	bench_case(out, "crossover_mask", "scalar", 1, op_crossover, &state);
+	bench_case(out, "point_crossover", "scalar", 1, op_point_crossover, &state);
+	state.config.mask_per_pair = 1;
+	bench_case(out, "crossover_mask", "per_pair", 1, op_crossover, &state);
+	ga_config_default(&state.config);
+
+	/*
+	** mask crossover with each instruction set this cpu supports.
+	*/
+	for (unsigned k = 0; k < sizeof cross_names / sizeof cross_names[0]; k++) {
+		if ((parents.cross = find_cross_kernels(cross_names[k])) != NULL) {
+			bench_case(out, "mask_crossover", cross_names[k], 1, op_mask_crossover, &state);
+		}
+	}
+	parents.cross = select_cross_kernels(node_number);
+
+	bench_case(out, "tournament_selection", "default", 0, op_tournament_selection, &state);
+	bench_case(out, "roulette_selection", "alias", 0, op_roulette_selection, &state);
+	bench_case(out, "roulette_table", "alias", 1, op_roulette_table, &state);
+	bench_case(out, "mutation", "geometric", 1, op_mutation, &state);
+	bench_case(out, "scaling", "default", 1, op_scaling, &state);
+
+	/*graph generation works on a graph of its own, the others keep theirs*/
+	state.graph = &scratch;
+	bench_case(out, "generate_random_graph", "default", 0, op_generate_random_graph, &state);
+
+	if (state.sink == -1.0) {
+		fprintf(stderr, "\n");	/*never true, it only keeps the results alive*/
+	}
+
+	free(infor.conflict_nodes);
+	free(infor.conflict_numbers);
+	free(state.conflicts);
+	alias_table_free(&state.roulette);
+	population_free(&parents);
+	population_free(&children);
+	graph_free(&scratch);
+	graph_free(&graph);
+}
+
+/*run the end-to-end case of one node number and density on instance_number graphs*/
+static void bench_solve(Bench_Output *out, int node_number, float d, int instance_number, Rng *master)
+{
+	for (int i = 0; i < instance_number; i++) {
+		Graph graph = {};
+		Rng rng;
+		Result *result = NULL;
+		double start = 0.0;
+		double seconds = 0.0;
+
+		rng_split(master, &rng);
+		generate_random_graph(&graph, node_number, d, &rng);
+		start = now_seconds();
+		result = genetic_algorithm(&graph, DEFAULT_POP_SIZE, NULL, &rng, NULL);
+		seconds = now_seconds() - start;
+
+		fprintf(out->file, "%s\n    { \"n\": %d, \"d\": %.2f, \"instance\": %d, \"success\": %s, \"generations\": %d, "
+			"\"evaluations\": %.0f, \"avoided_evaluations\": %.0f, \"seconds\": %.6f, \"evaluations_per_second\": %.1f }",
+			out->first ? "" : ",", node_number, d, i, result->success ? "true" : "false", result->loop_times,
+			result->eval_times, result->avoided_times, seconds, seconds > 0.0 ? result->eval_times / seconds : 0.0);
+		out->first = 0;
+		fprintf(stderr, "  solve n = %4d d = %5.2f instance %d: %s, %d generations, %.3f s\n",
+			node_number, d, i, result->success ? "success" : "fail", result->loop_times, seconds);
+
+		free(result);
+		graph_free(&graph);
+	}
+}
+
+/*write text as a JSON string*/
+static void write_json_string(FILE *file, char const *text)
+{
+	fputc('"', file);
+	for (; *text != '\0'; text++) {
+		if (*text == '"' || *text == '\\') {
+			fputc('\\', file);
+		}
+		fputc(*text, file);
+	}
+	fputc('"', file);
+}
+
+/*run the end-to-end case of the graph file at path, run_number runs with streams split from master*/
+static void bench_file(Bench_Output *out, char const *path, int run_number, Rng *master)
+{
+	Graph graph = {};
+
+	graph_load(&graph, path);
+	for (int i = 0; i < run_number; i++) {
+		Rng rng;
+		Result *result = NULL;
+		double start = 0.0;
+		double seconds = 0.0;
+
+		rng_split(master, &rng);
+		start = now_seconds();
+		result = genetic_algorithm(&graph, DEFAULT_POP_SIZE, NULL, &rng, NULL);
+		seconds = now_seconds() - start;
+
+		fprintf(out->file, "%s\n    { \"file\": ", out->first ? "" : ",");
+		write_json_string(out->file, path);
+		fprintf(out->file, ", \"n\": %d, \"e\": %d, \"run\": %d, \"success\": %s, \"generations\": %d, "
+			"\"evaluations\": %.0f, \"avoided_evaluations\": %.0f, \"seconds\": %.6f, \"evaluations_per_second\": %.1f }",
+			graph.node_number, graph.edge_number, i, result->success ? "true" : "false", result->loop_times,
+			result->eval_times, result->avoided_times, seconds, seconds > 0.0 ? result->eval_times / seconds : 0.0);
+		out->first = 0;
+		fprintf(stderr, "  file %s run %d: %s, %d generations, %.3f s\n",
+			path, i, result->success ? "success" : "fail", result->loop_times, seconds);
+
+		free(result);
+	}
+	graph_free(&graph);
+}
+
+int main(int argc, char *argv[])
+{
+	char const *positional[2] = { "-", NULL };
+	char const **graph_paths = (char const **)calloc(argc, sizeof(char const *));
+	int positional_count = 0;
+	int graph_count = 0;
+
+	if (graph_paths == NULL) {
+		printf("[BENCH.cpp--main--ERROR] cannot allocate memory\n");
+		exit(EXIT_FAILURE);
+	}
+	for (int i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "graph=", 6) == 0) {
+			graph_paths[graph_count++] = argv[i] + 6;
+		}
+		else if (positional_count < 2) {
+			positional[positional_count++] = argv[i];
+		}
+	}
+
+	char const *json_path = positional[0];
+	int quick = positional[1] != NULL;
+	int sweep_node_count = quick ? 2 : (int)(sizeof sweep_nodes / sizeof sweep_nodes[0]);
+	int solve_node_count = quick ? 1 : (int)(sizeof solve_nodes / sizeof solve_nodes[0]);
+	int instance_number = quick ? 1 : BENCH_INSTANCES;
+	char s_time[50] = "";
+	time_t current_time = time(NULL);
+	Bench_Output out;
+	Rng master;
+	Rng rng;
+
+	if (strcmp(json_path, "-") == 0) {
+		out.file = stdout;
+	}
+	else if ((out.file = fopen(json_path, "w")) == NULL) {
+		printf("[BENCH.cpp--main--ERROR] cannot open %s\n", json_path);
+		exit(EXIT_FAILURE);
+	}
+
+	time_to_string(&current_time, s_time, sizeof s_time);
+	s_time[strlen(s_time) - 1] = '\0';	/*remove the '\n' of the time string*/
+
+	fprintf(out.file, "{\n  \"version\": %d,\n  \"date\": \"%s\",\n  \"seed\": %lu,\n  \"quick\": %s,\n"
+		"  \"config\": { \"pop_size\": %d, \"max_loop\": %d, \"cross_method\": %d, \"select_method\": %d, \"use_hybrid\": %d, \"bit_kernels\": \"%s\" },",
+		BENCH_JSON_VERSION, s_time, BENCH_SEED, quick ? "true" : "false",
+		DEFAULT_POP_SIZE, MAX_LOOP, CROSS_METHOD, SELECT_METHOD, USE_HYBRID, select_bit_kernels(BIT_WORDS(900))->name);
+
+	/*
+	** kernel sweep. each case draws from its own stream, so adding a case does not change the others.
+	*/
+	fprintf(stderr, "kernels\n");
+	rng_seed(&master, RNG_DEFAULT, BENCH_SEED);
+	begin_array(&out, "kernels", 1);
+	for (int i = 0; i < sweep_node_count; i++) {
+		for (unsigned j = 0; j < sizeof sweep_ds / sizeof sweep_ds[0]; j++) {
+			rng_split(&master, &rng);
+			bench_kernels(&out, sweep_nodes[i], sweep_ds[j], &rng);
+		}
+	}
+	end_array(&out);
+
+	/*
+	** end-to-end runs on a fixed instance set.
+	*/
+	fprintf(stderr, "solve\n");
+	rng_seed(&master, RNG_DEFAULT, BENCH_SEED);
+	begin_array(&out, "solve", 0);
+	for (int i = 0; i < solve_node_count; i++) {
+		for (unsigned j = 0; j < sizeof solve_ds / sizeof solve_ds[0]; j++) {
+			bench_solve(&out, solve_nodes[i], solve_ds[j], instance_number, &master);
+		}
+	}
+	end_array(&out);
+
+	/*
+	** end-to-end runs on the graph files, each file draws from the same seed.
+	*/
+	fprintf(stderr, "files\n");
+	begin_array(&out, "files", 0);
+	for (int i = 0; i < graph_count; i++) {
+		rng_seed(&master, RNG_DEFAULT, BENCH_SEED);
+		bench_file(&out, graph_paths[i], instance_number, &master);
+	}
+	end_array(&out);
+
+	fprintf(out.file, "\n}\n");
+	if (out.file != stdout) {
+		fclose(out.file);
+	}
+	free(graph_paths);
+
+	return EXIT_SUCCESS;
+}
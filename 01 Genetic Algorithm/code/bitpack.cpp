@@ -0,0 +1,284 @@
+#include "bitpack.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define USE_X86_KERNELS	1	/*kernels for popcnt, avx2 and avx512 are compiled with target attributes*/
+#include <immintrin.h>
+#else
+#define USE_X86_KERNELS	0
+#endif
+
+/*count the bits of a word without any special instruction*/
+static inline int popcount64(uint64_t x)
+{
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+	return (int)((x * 0x0101010101010101ULL) >> 56);
+}
+
+/*
+** the outer loop of color_conflicts is the same for every instruction set, only the popcount of
+** row & mask differs. AND_POPCOUNT(row, mask) must be an expression which returns that popcount.
+*/
+#define COLOR_CONFLICTS_BODY(AND_POPCOUNT)	\
+	long total = 0;	\
+	for (int i = 0; i < node_number; i++) {	\
+		uint64_t const *row = rows + (size_t)i * words;	\
+		uint64_t const *mask = masks + (size_t)solution[i] * words;	\
+		int count = AND_POPCOUNT(row, mask);	\
+		if (node_conflicts != NULL) {	\
+			node_conflicts[i] = count;	\
+		}	\
+		total += count;	\
+	}	\
+	return total;
+
+/*popcount of row & mask, portable version*/
+static inline int and_popcount_portable(uint64_t const *row, uint64_t const *mask, int words)
+{
+	int count = 0;
+	for (int w = 0; w < words; w++) {
+		count += popcount64(row[w] & mask[w]);
+	}
+	return count;
+}
+
+#define AND_POPCOUNT_PORTABLE(row, mask)	and_popcount_portable(row, mask, words)
+
+static long color_conflicts_portable(uint64_t const *rows, int words, int node_number, uint64_t const *masks, char const *solution, int *node_conflicts)
+{
+	COLOR_CONFLICTS_BODY(AND_POPCOUNT_PORTABLE)
+}
+
+#if USE_X86_KERNELS
+
+/*popcount of row & mask with popcnt instruction*/
+__attribute__((target("popcnt")))
+static inline int and_popcount_popcnt(uint64_t const *row, uint64_t const *mask, int words)
+{
+	long long count = 0;
+	for (int w = 0; w < words; w++) {
+		count += _mm_popcnt_u64(row[w] & mask[w]);
+	}
+	return (int)count;
+}
+
+#define AND_POPCOUNT_POPCNT(row, mask)	and_popcount_popcnt(row, mask, words)
+
+__attribute__((target("popcnt")))
+static long color_conflicts_popcnt(uint64_t const *rows, int words, int node_number, uint64_t const *masks, char const *solution, int *node_conflicts)
+{
+	COLOR_CONFLICTS_BODY(AND_POPCOUNT_POPCNT)
+}
+
+/*popcount of row & mask with avx2. each byte is counted by a nibble lookup table, then bytes are summed by sad*/
+__attribute__((target("avx2,popcnt")))
+static inline int and_popcount_avx2(uint64_t const *row, uint64_t const *mask, int words)
+{
+	__m256i const lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	__m256i const low_mask = _mm256_set1_epi8(0x0f);
+	__m256i acc = _mm256_setzero_si256();
+	long long count = 0;
+	int w = 0;
+
+	for (; w + 4 <= words; w += 4) {
+		__m256i v = _mm256_and_si256(_mm256_loadu_si256((__m256i const *)(row + w)), _mm256_loadu_si256((__m256i const *)(mask + w)));
+		__m256i lo = _mm256_and_si256(v, low_mask);
+		__m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+		__m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+		acc = _mm256_add_epi64(acc, _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+	}
+	count = _mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1) + _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3);
+
+	for (; w < words; w++) {
+		count += _mm_popcnt_u64(row[w] & mask[w]);
+	}
+	return (int)count;
+}
+
+#define AND_POPCOUNT_AVX2(row, mask)	and_popcount_avx2(row, mask, words)
+
+__attribute__((target("avx2,popcnt")))
+static long color_conflicts_avx2(uint64_t const *rows, int words, int node_number, uint64_t const *masks, char const *solution, int *node_conflicts)
+{
+	COLOR_CONFLICTS_BODY(AND_POPCOUNT_AVX2)
+}
+
+/*popcount of row & mask with avx512 vpopcntq, the tail is loaded with a mask so no scalar loop is needed*/
+__attribute__((target("avx512f,avx512vpopcntdq")))
+static inline int and_popcount_avx512(uint64_t const *row, uint64_t const *mask, int words)
+{
+	__m512i acc = _mm512_setzero_si512();
+	int w = 0;
+
+	for (; w + 8 <= words; w += 8) {
+		__m512i v = _mm512_and_si512(_mm512_loadu_si512(row + w), _mm512_loadu_si512(mask + w));
+		acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(v));
+	}
+	if (w < words) {
+		__mmask8 tail = (__mmask8)((1u << (words - w)) - 1);
+		__m512i v = _mm512_and_si512(_mm512_maskz_loadu_epi64(tail, row + w), _mm512_maskz_loadu_epi64(tail, mask + w));
+		acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(v));
+	}
+	uint64_t lanes[8];
+	_mm512_storeu_si512(lanes, acc);
+	return (int)(lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7]);
+}
+
+#define AND_POPCOUNT_AVX512(row, mask)	and_popcount_avx512(row, mask, words)
+
+__attribute__((target("avx512f,avx512vpopcntdq")))
+static long color_conflicts_avx512(uint64_t const *rows, int words, int node_number, uint64_t const *masks, char const *solution, int *node_conflicts)
+{
+	COLOR_CONFLICTS_BODY(AND_POPCOUNT_AVX512)
+}
+
+#endif	/*USE_X86_KERNELS*/
+
+/*all kernels, the fastest first*/
+static Bit_Kernels const bit_kernel_table[] = {
+#if USE_X86_KERNELS
+	{ "avx512", 8, color_conflicts_avx512 },
+	{ "avx2", 4, color_conflicts_avx2 },
+	{ "popcnt", 0, color_conflicts_popcnt },
+#endif
+	{ "portable", 0, color_conflicts_portable },
+};
+
+/*check whether this cpu supports the kernels*/
+static int bit_kernels_supported(Bit_Kernels const *kernels)
+{
+#if USE_X86_KERNELS
+	if (strcmp(kernels->name, "avx512") == 0) {
+		return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq");
+	}
+	if (strcmp(kernels->name, "avx2") == 0) {
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+	}
+	if (strcmp(kernels->name, "popcnt") == 0) {
+		return __builtin_cpu_supports("popcnt");
+	}
+#endif
+	return strcmp(kernels->name, "portable") == 0;
+}
+
+/*select the fastest popcount kernels this cpu supports for rows of words*/
+Bit_Kernels const *select_bit_kernels(int words)
+{
+	int count = sizeof bit_kernel_table / sizeof bit_kernel_table[0];
+
+	/*
+	** the table is ordered from the fastest kernels, the portable kernels at the end are always supported.
+	*/
+	for (int i = 0; i < count - 1; i++) {
+		if (words >= bit_kernel_table[i].min_words && bit_kernels_supported(bit_kernel_table + i)) {
+			return bit_kernel_table + i;
+		}
+	}
+
+	return bit_kernel_table + count - 1;
+}
+
+/*find popcount kernels by name ("portable", "popcnt", "avx2" or "avx512"), NULL if this cpu does not support them*/
+Bit_Kernels const *find_bit_kernels(char const *name)
+{
+	for (unsigned i = 0; i < sizeof bit_kernel_table / sizeof bit_kernel_table[0]; i++) {
+		if (strcmp(bit_kernel_table[i].name, name) == 0) {
+			return bit_kernels_supported(bit_kernel_table + i) ? bit_kernel_table + i : NULL;
+		}
+	}
+
+	return NULL;
+}
+
+/*decide whether bitset adjacency is cheaper to scan than the adjacency lists of graph*/
+int graph_bits_worthwhile(Graph const *graph)
+{
+	/*
+	** a row scan costs BIT_WORDS(n) popcounts, an adjacency list scan costs one compare per neighbour.
+	** a popcount is about 3 times cheaper than a compare, so bitsets win while a row has at most 2 words
+	** per average degree.
+	*/
+	return graph->node_number > 0 && graph->node_number <= BIT_MAX_NODES &&
+		(long)BIT_WORDS(graph->node_number) * graph->node_number <= 4L * graph->edge_number;
+}
+
+/*build the bitset adjacency of graph from its adjacency lists*/
+void graph_build_bits(Graph *graph)
+{
+	int words = BIT_WORDS(graph->node_number);
+	size_t size = (size_t)graph->node_number * words;
+
+	/*
+	** the rows of the graph before are reused if they are large enough.
+	*/
+	if (size > graph->bit_capacity) {
+		graph_free_bits(graph);
+		if ((graph->bit_rows = (uint64_t *)malloc(size * sizeof(uint64_t))) == NULL) {
+			printf("[BITPACK.cpp--graph_build_bits--ERROR] cannot allocate memory\n");
+			exit(EXIT_FAILURE);
+		}
+		graph->bit_capacity = size;
+	}
+	memset(graph->bit_rows, 0, size * sizeof(uint64_t));
+	graph->bit_words = words;
+	graph->bit_kernels = select_bit_kernels(words);
+
+	for (int i = 0; i < graph->node_number; i++) {
+		uint64_t *row = graph->bit_rows + (size_t)i * words;
+		for (int k = graph->offsets[i]; k < graph->offsets[i + 1]; k++) {
+			int j = graph->neighbours[k];
+			row[j / 64] |= 1ULL << (j % 64);
+		}
+	}
+}
+
+/*release the bitset adjacency of graph*/
+void graph_free_bits(Graph *graph)
+{
+	free(graph->bit_rows);
+	graph->bit_rows = NULL;
+	graph->bit_capacity = 0;
+	graph->bit_words = 0;
+	graph->bit_kernels = NULL;
+}
+
+/*pack a solution into 3 color masks, color c is masks[c * BIT_WORDS(node_number)] ...*/
+void pack_solution(char const *solution, int node_number, uint64_t *masks)
+{
+	int words = BIT_WORDS(node_number);
+
+	memset(masks, 0, 3 * (size_t)words * sizeof(uint64_t));
+	for (int i = 0; i < node_number; i++) {
+		masks[(size_t)solution[i] * words + i / 64] |= 1ULL << (i % 64);
+	}
+}
+
+/*pack a solution into 2 bits per gene, packed holds (node_number + 3) / 4 bytes*/
+void pack_genes(char const *solution, int node_number, unsigned char *packed)
+{
+	memset(packed, 0, (node_number + 3) / 4);
+	for (int i = 0; i < node_number; i++) {
+		packed[i / 4] |= (unsigned char)(solution[i] << (2 * (i % 4)));
+	}
+}
+
+/*unpack 2 bits per gene into a solution*/
+void unpack_genes(unsigned char const *packed, int node_number, char *solution)
+{
+	for (int i = 0; i < node_number; i++) {
+		solution[i] = (packed[i / 4] >> (2 * (i % 4))) & 3;
+	}
+}
+
+/*count the conflict links of a solution with the bitset adjacency of graph, node conflicts are written if it is not NULL*/
+long bit_conflicts(Bit_Kernels const *kernels, Graph const *graph, char const *solution, int *node_conflicts)
+{
+	uint64_t masks[3 * BIT_WORDS(BIT_MAX_NODES)];	/*bitset adjacency is only built for small graphs, so the masks fit on stack*/
+
+	pack_solution(solution, graph->node_number, masks);
+
+	/*each conflict link is counted from both of its ends*/
+	return kernels->color_conflicts(graph->bit_rows, graph->bit_words, graph->node_number, masks, solution, node_conflicts) / 2;
+}
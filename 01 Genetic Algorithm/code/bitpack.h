@@ -0,0 +1,53 @@
+#ifndef _HEADER_BITPACK_H
+#define _HEADER_BITPACK_H	1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "problem.h"
+
+#define BIT_MAX_NODES	4096	/*graphs with more nodes never get bitset adjacency, its memory grows with N^2*/
+#define BIT_WORDS(n)	(((n) + 63) / 64)	/*number of 64-bit words of a bitset of n nodes*/
+
+/*popcount kernels of one instruction set*/
+typedef struct bit_kernels {
+	char const *name;	/*name of instruction set*/
+	int min_words;	/*rows shorter than this are faster with narrower kernels*/
+
+	/*
+	** count the neighbours which have the same color as each node. rows is the bitset adjacency, masks holds
+	** the 3 color masks of the solution. node_conflicts may be NULL. return the sum of all counts.
+	*/
+	long(*color_conflicts)(uint64_t const *rows, int words, int node_number, uint64_t const *masks, char const *solution, int *node_conflicts);
+} Bit_Kernels;
+
+/*select the fastest popcount kernels this cpu supports for rows of words*/
+Bit_Kernels const *select_bit_kernels(int words);
+
+/*find popcount kernels by name ("portable", "popcnt", "avx2" or "avx512"), NULL if this cpu does not support them*/
+Bit_Kernels const *find_bit_kernels(char const *name);
+
+/*decide whether bitset adjacency is cheaper to scan than the adjacency lists of graph*/
+int graph_bits_worthwhile(Graph const *graph);
+
+/*build the bitset adjacency of graph from its adjacency lists, and select its popcount kernels*/
+void graph_build_bits(Graph *graph);
+
+/*release the bitset adjacency of graph*/
+void graph_free_bits(Graph *graph);
+
+/*pack a solution into 3 color masks, color c is masks[c * BIT_WORDS(node_number)] ...*/
+void pack_solution(char const *solution, int node_number, uint64_t *masks);
+
+/*pack a solution into 2 bits per gene, packed holds (node_number + 3) / 4 bytes*/
+void pack_genes(char const *solution, int node_number, unsigned char *packed);
+
+/*unpack 2 bits per gene into a solution*/
+void unpack_genes(unsigned char const *packed, int node_number, char *solution);
+
+/*count the conflict links of a solution with the bitset adjacency of graph, node conflicts are written if it is not NULL*/
+long bit_conflicts(Bit_Kernels const *kernels, Graph const *graph, char const *solution, int *node_conflicts);
+
+#endif
@@ -0,0 +1,339 @@
+#include "bitslice.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define USE_X86_KERNELS	1	/*kernels for avx2 and avx512 are compiled with target attributes*/
+#include <immintrin.h>
+#else
+#define USE_X86_KERNELS	0
+#endif
+
+#define SLICE_COUNTERS	32	/*vertical counters of a lane, the conflict links of a solution are fewer than 2^31*/
+
+/*spread 8 bits to the bytes of a word, byte k is bit k of bits*/
+static inline uint64_t spread_bytes(unsigned bits)
+{
+	uint64_t x = (bits * 0x0101010101010101ULL) & 0x8040201008040201ULL;	/*byte k keeps bit k*/
+
+	return ((x + 0x7f7f7f7f7f7f7f7fULL) & 0x8080808080808080ULL) >> 7;
+}
+
+/*
+** add the node conflicts of node in the first count lanes of a block, they are read from top vertical counters,
+** counter b is words[b * lane_words] .... 8 lanes at a time: bit b of their counts is spread to 8 bytes and
+** shifted by b, so the counts of the 8 lanes end up in the bytes of one word.
+*/
+static void extract_node_conflicts(uint64_t const *words, int top, int lane_words, int count, int node, int node_number,
+	int *conflicts, int *node_conflicts)
+{
+	for (int lane = 0; lane < count; lane += 8) {
+		uint64_t counts = 0;
+
+		for (int b = 0; b < top; b++) {
+			counts += spread_bytes((unsigned)(words[b * lane_words + lane / 64] >> (lane % 64)) & 0xff) << b;
+		}
+		for (int m = 0; m < 8 && lane + m < count; m++) {
+			int count_m = (int)(counts >> (8 * m)) & 0xff;
+
+			node_conflicts[(size_t)(lane + m) * node_number + node] = count_m;
+			conflicts[lane + m] += count_m;
+		}
+	}
+}
+
+/*read the counts of the first count lanes of a block from top vertical counters, counter b is words[b * lane_words] ...*/
+static void extract_conflicts(uint64_t const *words, int top, int lane_words, int count, int *conflicts)
+{
+	for (int lane = 0; lane < count; lane++) {
+		unsigned value = 0;
+
+		for (int b = 0; b < top; b++) {
+			value |= (unsigned)((words[b * lane_words + lane / 64] >> (lane % 64)) & 1) << b;
+		}
+		conflicts[lane] = (int)value;
+	}
+}
+
+/*
+** the loop over the nodes is the same for every instruction set, only the word of lanes differs. it is given by
+** LANE (its type), LANE_LOAD(p), LANE_STORE(p, v), LANE_XOR(a, b), LANE_OR(a, b), LANE_AND(a, b),
+** LANE_EQUAL(d) (the lanes in which d is 0) and LANE_ANY(v) (whether any lane of v is set).
+** a conflicting link is added to the vertical counters like a 1 to a binary number: counter b flips
+** where the carry is set and the carry moves on where it was set, it stops once no lane carries.
+** the counters are kept per node if node conflicts are wanted, else for the whole block.
+*/
+#define BLOCK_CONFLICTS_BODY	\
+	int const lane_words = (int)(sizeof(LANE) / sizeof(uint64_t));	\
+	int const node_number = graph->node_number;	\
+	LANE counters[SLICE_COUNTERS];	\
+	uint64_t words[SLICE_COUNTERS * sizeof(LANE) / sizeof(uint64_t)];	\
+	int top = 0;	\
+	if (node_conflicts != NULL) {	\
+		memset(conflicts, 0, count * sizeof(int));	\
+	}	\
+	for (int i = 0; i < node_number; i++) {	\
+		uint64_t const *plane = planes + (size_t)2 * i * lane_words;	\
+		LANE high = LANE_LOAD(plane);	\
+		LANE low = LANE_LOAD(plane + lane_words);	\
+		if (node_conflicts != NULL) {	\
+			top = 0;	\
+		}	\
+		for (int k = graph->offsets[i]; k < graph->offsets[i + 1]; k++) {	\
+			int j = graph->neighbours[k];	\
+			uint64_t const *other = planes + (size_t)2 * j * lane_words;	\
+			LANE carry;	\
+			int b = 0;	\
+			if (node_conflicts == NULL && j < i) {	\
+				continue;	/*without node conflicts each link is counted from its smaller end*/	\
+			}	\
+			carry = LANE_EQUAL(LANE_OR(LANE_XOR(high, LANE_LOAD(other)), LANE_XOR(low, LANE_LOAD(other + lane_words))));	\
+			for (; b < top && LANE_ANY(carry); b++) {	\
+				LANE next = LANE_AND(counters[b], carry);	\
+				counters[b] = LANE_XOR(counters[b], carry);	\
+				carry = next;	\
+			}	\
+			if (LANE_ANY(carry)) {	\
+				counters[top++] = carry;	\
+			}	\
+		}	\
+		if (node_conflicts != NULL) {	\
+			for (int b = 0; b < top; b++) {	\
+				LANE_STORE(words + b * lane_words, counters[b]);	\
+			}	\
+			extract_node_conflicts(words, top, lane_words, count, i, node_number, conflicts, node_conflicts);	\
+		}	\
+	}	\
+	if (node_conflicts != NULL) {	\
+		for (int lane = 0; lane < count; lane++) {	\
+			conflicts[lane] /= 2;	/*each conflict link is counted from both of its ends*/	\
+		}	\
+		return;	\
+	}	\
+	for (int b = 0; b < top; b++) {	\
+		LANE_STORE(words + b * lane_words, counters[b]);	\
+	}	\
+	extract_conflicts(words, top, lane_words, count, conflicts);
+
+/*64 lanes in a 64-bit word*/
+#define LANE	uint64_t
+#define LANE_LOAD(p)	(*(p))
+#define LANE_STORE(p, v)	(*(p) = (v))
+#define LANE_XOR(a, b)	((a) ^ (b))
+#define LANE_OR(a, b)	((a) | (b))
+#define LANE_AND(a, b)	((a) & (b))
+#define LANE_EQUAL(d)	(~(d))
+#define LANE_ANY(v)	((v) != 0)
+
+static void block_conflicts_portable(Graph const *graph, uint64_t const *planes, int count, int *conflicts, int *node_conflicts)
+{
+	BLOCK_CONFLICTS_BODY
+}
+
+#undef LANE
+#undef LANE_LOAD
+#undef LANE_STORE
+#undef LANE_XOR
+#undef LANE_OR
+#undef LANE_AND
+#undef LANE_EQUAL
+#undef LANE_ANY
+
+#if USE_X86_KERNELS
+
+/*256 lanes in an avx2 register*/
+#define LANE	__m256i
+#define LANE_LOAD(p)	_mm256_loadu_si256((__m256i const *)(p))
+#define LANE_STORE(p, v)	_mm256_storeu_si256((__m256i *)(p), (v))
+#define LANE_XOR(a, b)	_mm256_xor_si256((a), (b))
+#define LANE_OR(a, b)	_mm256_or_si256((a), (b))
+#define LANE_AND(a, b)	_mm256_and_si256((a), (b))
+#define LANE_EQUAL(d)	_mm256_andnot_si256((d), _mm256_set1_epi64x(-1))
+#define LANE_ANY(v)	(!_mm256_testz_si256((v), (v)))
+
+__attribute__((target("avx2")))
+static void block_conflicts_avx2(Graph const *graph, uint64_t const *planes, int count, int *conflicts, int *node_conflicts)
+{
+	BLOCK_CONFLICTS_BODY
+}
+
+#undef LANE
+#undef LANE_LOAD
+#undef LANE_STORE
+#undef LANE_XOR
+#undef LANE_OR
+#undef LANE_AND
+#undef LANE_EQUAL
+#undef LANE_ANY
+
+/*512 lanes in an avx512 register*/
+#define LANE	__m512i
+#define LANE_LOAD(p)	_mm512_loadu_si512((p))
+#define LANE_STORE(p, v)	_mm512_storeu_si512((p), (v))
+#define LANE_XOR(a, b)	_mm512_xor_si512((a), (b))
+#define LANE_OR(a, b)	_mm512_or_si512((a), (b))
+#define LANE_AND(a, b)	_mm512_and_si512((a), (b))
+#define LANE_EQUAL(d)	_mm512_xor_si512((d), _mm512_set1_epi64(-1))
+#define LANE_ANY(v)	(_mm512_test_epi64_mask((v), (v)) != 0)
+
+__attribute__((target("avx512f")))
+static void block_conflicts_avx512(Graph const *graph, uint64_t const *planes, int count, int *conflicts, int *node_conflicts)
+{
+	BLOCK_CONFLICTS_BODY
+}
+
+#undef LANE
+#undef LANE_LOAD
+#undef LANE_STORE
+#undef LANE_XOR
+#undef LANE_OR
+#undef LANE_AND
+#undef LANE_EQUAL
+#undef LANE_ANY
+
+#endif	/*USE_X86_KERNELS*/
+
+/*all kernels, the widest first*/
+static Slice_Kernels const slice_kernel_table[] = {
+#if USE_X86_KERNELS
+	{ "avx512", 512, 257, block_conflicts_avx512 },
+	{ "avx2", 256, 65, block_conflicts_avx2 },
+#endif
+	{ "portable", 64, 0, block_conflicts_portable },
+};
+
+/*check whether this cpu supports the kernels*/
+static int slice_kernels_supported(Slice_Kernels const *kernels)
+{
+#if USE_X86_KERNELS
+	if (strcmp(kernels->name, "avx512") == 0) {
+		return __builtin_cpu_supports("avx512f");
+	}
+	if (strcmp(kernels->name, "avx2") == 0) {
+		return __builtin_cpu_supports("avx2");
+	}
+#endif
+	return strcmp(kernels->name, "portable") == 0;
+}
+
+/*select the fastest bitsliced kernels this cpu supports for count solutions*/
+Slice_Kernels const *select_slice_kernels(int count)
+{
+	int number = sizeof slice_kernel_table / sizeof slice_kernel_table[0];
+
+	/*
+	** a block costs the same for any number of solutions up to its lanes, so wide kernels only pay off for many solutions.
+	*/
+	for (int i = 0; i < number - 1; i++) {
+		if (count >= slice_kernel_table[i].min_count && slice_kernels_supported(slice_kernel_table + i)) {
+			return slice_kernel_table + i;
+		}
+	}
+
+	return slice_kernel_table + number - 1;
+}
+
+/*find bitsliced kernels by name ("portable", "avx2" or "avx512"), NULL if this cpu does not support them*/
+Slice_Kernels const *find_slice_kernels(char const *name)
+{
+	for (unsigned i = 0; i < sizeof slice_kernel_table / sizeof slice_kernel_table[0]; i++) {
+		if (strcmp(slice_kernel_table[i].name, name) == 0) {
+			return slice_kernels_supported(slice_kernel_table + i) ? slice_kernel_table + i : NULL;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+** transpose count solutions of node_number genes into the bit planes of a block of lane_words * 64 lanes,
+** solution k is genes[k * node_number] .... planes holds 2 * lane_words words per node, lanes after count are 0.
+*/
+void slice_pack(char const *genes, int count, int node_number, int lane_words, uint64_t *planes)
+{
+	memset(planes, 0, (size_t)2 * node_number * lane_words * sizeof(uint64_t));
+
+	/*
+	** 8 genes of 8 solutions at a time. the color bits of the genes of solution m are moved to bit m of their bytes,
+	** then byte j of the merged words holds the bits of gene j of the 8 solutions, one byte of the planes of node j.
+	*/
+	for (int lane = 0; lane < count; lane += 8) {
+		int lanes = count - lane < 8 ? count - lane : 8;
+		int word = lane / 64;
+		int shift = lane % 64;
+
+		for (int i = 0; i < node_number; i += 8) {
+			int gene_count = node_number - i < 8 ? node_number - i : 8;
+			uint64_t high = 0;
+			uint64_t low = 0;
+
+			for (int m = 0; m < lanes; m++) {
+				uint64_t x = 0;
+
+				memcpy(&x, genes + (size_t)(lane + m) * node_number + i, gene_count);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+				x = __builtin_bswap64(x);	/*gene j is byte j from the lowest one*/
+#endif
+				high |= ((x >> 1) & 0x0101010101010101ULL) << m;
+				low |= (x & 0x0101010101010101ULL) << m;
+			}
+			for (int j = 0; j < gene_count; j++) {
+				uint64_t *plane = planes + (size_t)2 * (i + j) * lane_words + word;
+
+				plane[0] |= ((high >> (8 * j)) & 0xff) << shift;
+				plane[lane_words] |= ((low >> (8 * j)) & 0xff) << shift;
+			}
+		}
+	}
+}
+
+/*number of words of the bit planes of one block of kernels on graphs of node_number nodes*/
+size_t slice_plane_words(Slice_Kernels const *kernels, int node_number)
+{
+	return (size_t)2 * node_number * (kernels->lanes / 64);
+}
+
+/*
+** count the conflict links of count solutions, kernels->lanes solutions at a time. solution k is genes[k * node_number] ...,
+** its conflict links go to conflicts[k] and, if node_conflicts is not NULL, its node conflicts to node_conflicts[k * node_number] ...
+** planes is room for slice_plane_words() words, NULL means it is allocated for this call.
+*/
+void slice_conflicts(Slice_Kernels const *kernels, Graph const *graph, char const *genes, int count, int *conflicts, int *node_conflicts,
+	uint64_t *planes)
+{
+	int node_number = graph->node_number;
+	int lane_words = kernels->lanes / 64;
+	int max_degree = 0;
+	uint64_t *own_planes = NULL;
+
+	/*
+	** node conflicts are counted in a byte per lane, a graph with a larger degree is evaluated one solution at a time.
+	*/
+	for (int i = 0; node_conflicts != NULL && i < node_number; i++) {
+		int degree = graph->offsets[i + 1] - graph->offsets[i];
+		max_degree = degree > max_degree ? degree : max_degree;
+	}
+	if (max_degree > SLICE_MAX_DEGREE) {
+		for (int k = 0; k < count; k++) {
+			Conflict_State state;
+
+			state.node_conflicts = node_conflicts + (size_t)k * node_number;
+			conflict_state_init(graph, genes + (size_t)k * node_number, &state);
+			conflicts[k] = state.conflict;
+		}
+		return;
+	}
+
+	if (planes == NULL && (planes = own_planes = (uint64_t *)malloc(slice_plane_words(kernels, node_number) * sizeof(uint64_t))) == NULL) {
+		printf("[BITSLICE.cpp--slice_conflicts--ERROR] cannot allocate memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for (int first = 0; first < count; first += kernels->lanes) {
+		int block = count - first < kernels->lanes ? count - first : kernels->lanes;
+
+		slice_pack(genes + (size_t)first * node_number, block, node_number, lane_words, planes);
+		kernels->block_conflicts(graph, planes, block, conflicts + first,
+			node_conflicts != NULL ? node_conflicts + (size_t)first * node_number : NULL);
+	}
+
+	free(own_planes);
+}
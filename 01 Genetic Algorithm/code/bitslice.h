@@ -0,0 +1,56 @@
+#ifndef _HEADER_BITSLICE_H
+#define _HEADER_BITSLICE_H	1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "problem.h"
+
+#define SLICE_MAX_DEGREE	255	/*node conflicts of graphs with a larger degree are not bitsliced, a count must fit in a byte*/
+
+/*
+** bitsliced conflict kernels of one instruction set. the solutions of a block are transposed into bit planes:
+** for each node, one word of lanes holds the high bit of the color of every solution and one the low bit,
+** solution k is lane k. the edges are walked once per block, and a link conflicts in the lanes where both
+** planes of its ends are equal. the conflicts of each lane are added up in vertical counters, bit b of the
+** counts of all lanes is one word of lanes.
+*/
+typedef struct slice_kernels {
+	char const *name;	/*name of instruction set*/
+	int lanes;	/*number of solutions of a block, a multiple of 64*/
+	int min_count;	/*fewer solutions are faster with narrower kernels*/
+
+	/*
+	** count the conflict links of the count solutions of a block, planes holds 2 * lanes / 64 words per node
+	** (see slice_pack). conflicts[k] gets the conflict links of lane k. if node_conflicts is not NULL,
+	** node_conflicts[k * node_number] ... get the node conflicts of lane k, the degree must be at most SLICE_MAX_DEGREE then.
+	*/
+	void(*block_conflicts)(Graph const *graph, uint64_t const *planes, int count, int *conflicts, int *node_conflicts);
+} Slice_Kernels;
+
+/*select the fastest bitsliced kernels this cpu supports for count solutions*/
+Slice_Kernels const *select_slice_kernels(int count);
+
+/*find bitsliced kernels by name ("portable", "avx2" or "avx512"), NULL if this cpu does not support them*/
+Slice_Kernels const *find_slice_kernels(char const *name);
+
+/*
+** transpose count solutions of node_number genes into the bit planes of a block of lane_words * 64 lanes,
+** solution k is genes[k * node_number] .... planes holds 2 * lane_words words per node, lanes after count are 0.
+*/
+void slice_pack(char const *genes, int count, int node_number, int lane_words, uint64_t *planes);
+
+/*number of words of the bit planes of one block of kernels on graphs of node_number nodes*/
+size_t slice_plane_words(Slice_Kernels const *kernels, int node_number);
+
+/*
+** count the conflict links of count solutions, kernels->lanes solutions at a time. solution k is genes[k * node_number] ...,
+** its conflict links go to conflicts[k] and, if node_conflicts is not NULL, its node conflicts to node_conflicts[k * node_number] ...
+** planes is room for slice_plane_words() words, NULL means it is allocated for this call.
+*/
+void slice_conflicts(Slice_Kernels const *kernels, Graph const *graph, char const *genes, int count, int *conflicts, int *node_conflicts,
+	uint64_t *planes);
+
+#endif
@@ -0,0 +1,164 @@
+#include "campaign.h"
+#include "threadpool.h"
+
+#include <mutex>
+#include <thread>
+
+/*shared state of a running campaign*/
+typedef struct Campaign_Run {
+	Campaign *campaign;
+	Graph *graphs;	/*one graph buffer per worker*/
+	Thread_Pool **run_pools;	/*one pool per worker for the generations or the islands of its runs, NULL entries mean serial runs*/
+	double *eval_sums;	/*sum of evaluation times of the successful runs of each d*/
+	std::mutex lock;	/*protects outputs and serializes the callback*/
+} Campaign_Run;
+
+/*one (d, run) job*/
+typedef struct Campaign_Job {
+	Campaign_Run *shared;
+	int d_index;
+	int run;
+	Rng rng;	/*stream of the job, split from the master generator*/
+} Campaign_Job;
+
+/*run one job on a worker*/
+static void campaign_job(void *arg, int worker)
+{
+	Campaign_Job *job = (Campaign_Job *)arg;
+	Campaign_Run *shared = job->shared;
+	Campaign *campaign = shared->campaign;
+	Graph const *graph = campaign->graph;
+
+	if (graph == NULL) {
+		generate_random_graph(shared->graphs + worker, campaign->node_number, campaign->d_list[job->d_index], &job->rng);
+		graph = shared->graphs + worker;
+	}
+	Result *p_result = NULL;
+	if (campaign->portfolio != NULL) {
+		p_result = portfolio_algorithm(graph, campaign->pop_size, campaign->portfolio, &job->rng, NULL);
+	}
+	else if (campaign->islands != NULL) {
+		p_result = island_algorithm(graph, campaign->pop_size, campaign->islands, campaign->config, &job->rng, shared->run_pools[worker]);
+	}
+	else {
+		p_result = genetic_algorithm(graph, campaign->pop_size, campaign->config, &job->rng, shared->run_pools[worker]);
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(shared->lock);
+
+		if (p_result->success) {
+			campaign->sr_list[job->d_index] += 1;
+			shared->eval_sums[job->d_index] += p_result->eval_times;
+		}
+		if (campaign->profile != NULL) {
+			profile_merge(campaign->profile, &p_result->profile);
+		}
+		if (campaign->on_result != NULL) {
+			campaign->on_result(job->d_index, job->run, graph, p_result, campaign->user);
+		}
+	}
+
+	/*
+	** the sink writes on its own thread, the job only waits here if its queue is full.
+	*/
+	if (campaign->sink != NULL) {
+		result_sink_put(campaign->sink, job->d_index, campaign->d_list[job->d_index], job->run, p_result);
+	}
+	else {
+		free(p_result);
+	}
+}
+
+/*run all jobs of a campaign and fill sr_list and avg_eval_list*/
+void run_campaign(Campaign *campaign)
+{
+	int job_number = campaign->d_number * campaign->max_run;
+	int worker_count = campaign->thread_count;
+	Thread_Pool *pool = NULL;
+	int thread_count = 0;
+
+	/*
+	** the islands of a job run on a pool of the job's worker, so there are only as many workers as the threads fit.
+	*/
+	if (campaign->portfolio == NULL && campaign->islands != NULL) {
+		if (worker_count <= 0) {
+			worker_count = (int)std::thread::hardware_concurrency();
+		}
+		worker_count /= campaign->islands->island_number;
+		worker_count = worker_count > 1 ? worker_count : 1;
+	}
+	pool = thread_pool_create(worker_count);
+	thread_count = thread_pool_size(pool);
+
+	Campaign_Run shared;
+	shared.campaign = campaign;
+	shared.graphs = (Graph *)calloc(thread_count, sizeof(Graph));
+	shared.run_pools = (Thread_Pool **)calloc(thread_count, sizeof(Thread_Pool *));
+	shared.eval_sums = (double *)calloc(campaign->d_number, sizeof(double));
+	Campaign_Job *jobs = (Campaign_Job *)malloc(job_number * sizeof(Campaign_Job));
+	Rng master;
+
+	if (shared.graphs == NULL || shared.run_pools == NULL || shared.eval_sums == NULL || jobs == NULL) {
+		printf("[CAMPAIGN.cpp--run_campaign--ERROR] cannot allocate memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/*
+	** the pools of the runs are created once and reused by every run of their worker.
+	*/
+	if (campaign->portfolio == NULL && campaign->islands != NULL) {
+		for (int i = 0; i < thread_count; i++) {
+			shared.run_pools[i] = thread_pool_create(campaign->islands->island_number);
+		}
+	}
+	else if (campaign->run_thread_count > 1) {
+		for (int i = 0; i < thread_count; i++) {
+			shared.run_pools[i] = thread_pool_create(campaign->run_thread_count);
+		}
+	}
+
+	memset(campaign->sr_list, 0, campaign->d_number * sizeof(int));
+	memset(campaign->avg_eval_list, 0, campaign->d_number * sizeof(double));
+
+	/*
+	** every job gets its own stream, split in job order, so results do not depend on which worker runs a job.
+	*/
+	rng_seed(&master, campaign->rng_kind, campaign->seed);
+	for (int k = 0; k < job_number; k++) {
+		rng_split(&master, &jobs[k].rng);
+	}
+
+	/*
+	** submit all jobs, run times differ a lot between d values, idle workers steal the remaining jobs of busy ones.
+	*/
+	for (int k = 0; k < job_number; k++) {
+		jobs[k].shared = &shared;
+		jobs[k].d_index = k / campaign->max_run;
+		jobs[k].run = k % campaign->max_run;
+		thread_pool_submit(pool, campaign_job, jobs + k);
+	}
+
+	thread_pool_wait(pool);
+	thread_pool_destroy(pool);
+
+	/*
+	** average evaluation times of each d, the same way as the single thread loop.
+	*/
+	for (int i = 0; i < campaign->d_number; i++) {
+		if (campaign->sr_list[i] > 0) {
+			campaign->avg_eval_list[i] = shared.eval_sums[i] / campaign->sr_list[i];
+		}
+	}
+
+	for (int i = 0; i < thread_count; i++) {
+		graph_free(shared.graphs + i);
+		if (shared.run_pools[i] != NULL) {
+			thread_pool_destroy(shared.run_pools[i]);
+		}
+	}
+	free(shared.graphs);
+	free(shared.run_pools);
+	free(shared.eval_sums);
+	free(jobs);
+}
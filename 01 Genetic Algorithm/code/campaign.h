@@ -0,0 +1,47 @@
+#ifndef _HEADER_CAMPAIGN_H
+#define _HEADER_CAMPAIGN_H	1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "problem.h"
+#include "geneticalgorithm.h"
+#include "island.h"
+#include "portfolio.h"
+#include "results.h"
+
+/*called for each finished run. calls are serialized, so the callback needs no lock of its own*/
+typedef void(*Campaign_Callback)(int d_index, int run, Graph const *graph, Result const *result, void *user);
+
+/*
+** an experiment campaign: for each d in d_list, max_run random graphs are generated and solved, or max_run runs
+** solve the graph of the campaign if it has one. all (d, run) jobs are spread over a thread pool.
+*/
+typedef struct Campaign {
+	int node_number;	/*node number of graphs*/
+	Graph const *graph;	/*if it is not NULL every run solves it instead of a random graph, then d_list only labels the runs*/
+	int pop_size;	/*population size of genetic algorithm*/
+	int max_run;	/*number of runs of each d*/
+	int d_number;	/*length of d list*/
+	float const *d_list;	/*constraint densities*/
+	int thread_count;	/*number of threads, <= 0 means one thread per core. with islands it is shared out, each job gets island_number of them*/
+	int run_thread_count;	/*number of threads which share the generations of one run, <= 1 means the job's own thread only. not used with islands*/
+	GA_Config const *config;	/*operators and parameters of the GA, NULL means the defaults*/
+	Island_Config const *islands;	/*island model of each run, NULL means one population per run*/
+	Portfolio_Config const *portfolio;	/*solvers which race on each run, NULL means the GA alone. it goes before islands*/
+	unsigned long seed;	/*master seed, the stream of each job is split from it in job order*/
+	int rng_kind;	/*generator of the streams, RNG_XOSHIRO or RNG_MT*/
+	Campaign_Callback on_result;	/*called for each finished run, it may be NULL*/
+	void *user;	/*passed to on_result*/
+	Result_Sink *sink;	/*finished results are handed to it after on_result, NULL means they are just released*/
+
+	int *sr_list;	/*output: success times of each d, d_number elements*/
+	double *avg_eval_list;	/*output: average evaluation times of the successful runs of each d, d_number elements*/
+	Profile *profile;	/*output: if it is not NULL, the profiles of all runs are added to it (see GA_PROFILE)*/
+} Campaign;
+
+/*run all jobs of a campaign and fill sr_list and avg_eval_list*/
+void run_campaign(Campaign *campaign);
+
+#endif
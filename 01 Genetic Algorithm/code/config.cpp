@@ -0,0 +1,223 @@
+#include "config.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <stddef.h>
+
+#define SETTING_SIZE	256	/*longest setting or config file line*/
+
+/*a key of the config and where its value is kept*/
+typedef struct Config_Key {
+	char const *name;
+	int is_double;	/*1 for a double value, 0 for an int value*/
+	size_t offset;	/*offset of the value in GA_Config*/
+} Config_Key;
+
+static Config_Key const config_keys[] = {
+	{ "max_loop", 0, offsetof(GA_Config, max_loop) },
+	{ "mutate_rate", 1, offsetof(GA_Config, mutate_rate) },
+	{ "use_elite", 0, offsetof(GA_Config, use_elite) },
+	{ "use_scaling", 0, offsetof(GA_Config, use_scaling) },
+	{ "cross_method", 0, offsetof(GA_Config, cross_method) },
+	{ "mask_per_pair", 0, offsetof(GA_Config, mask_per_pair) },
+	{ "select_method", 0, offsetof(GA_Config, select_method) },
+	{ "k_candidate", 0, offsetof(GA_Config, k_candidate) },
+	{ "use_hybrid", 0, offsetof(GA_Config, use_hybrid) },
+	{ "hybrid", 0, offsetof(GA_Config, hybrid) },
+	{ "tabu_iterations", 0, offsetof(GA_Config, tabu_iterations) },
+	{ "tabu_tenure", 0, offsetof(GA_Config, tabu_tenure) },
+	{ "tabu_alpha", 1, offsetof(GA_Config, tabu_alpha) },
+	{ "eval_cache", 0, offsetof(GA_Config, eval_cache) },
+};
+
+/*set config to the default values above*/
+void ga_config_default(GA_Config *config)
+{
+	config->max_loop = MAX_LOOP;
+	config->mutate_rate = MUTATE_RATE;
+	config->use_elite = USE_ELITE;
+	config->use_scaling = USE_SCALING;
+	config->cross_method = CROSS_METHOD;
+	config->mask_per_pair = MASK_PER_PAIR;
+	config->select_method = SELECT_METHOD;
+	config->k_candidate = K_CANDIDATE;
+	config->use_hybrid = USE_HYBRID;
+	config->hybrid = HYBRID;
+	config->tabu_iterations = TABU_ITERATIONS;
+	config->tabu_tenure = TABU_TENURE;
+	config->tabu_alpha = TABU_ALPHA;
+	config->eval_cache = EVAL_CACHE;
+}
+
+/*remove the spaces at both ends of text*/
+static char *trim(char *text)
+{
+	char *end = text + strlen(text);
+
+	while (isspace((unsigned char)*text)) {
+		text++;
+	}
+	while (end > text && isspace((unsigned char)end[-1])) {
+		*--end = '\0';
+	}
+	return text;
+}
+
+/*
+** apply one "key=value" setting like ga_config_set, but return what is wrong with it instead of stopping:
+** NULL if it was applied, else a message, and config is not changed.
+*/
+char const *ga_config_apply(GA_Config *config, char const *setting)
+{
+	char buffer[SETTING_SIZE] = "";
+	char *equal = NULL;
+	char *key = NULL;
+	char *value = NULL;
+	char *end = NULL;
+
+	if (strlen(setting) >= sizeof buffer || (equal = strchr(strcpy(buffer, setting), '=')) == NULL) {
+		return "not a key=value setting";
+	}
+	*equal = '\0';
+	key = trim(buffer);
+	value = trim(equal + 1);
+
+	for (size_t i = 0; i < sizeof config_keys / sizeof config_keys[0]; i++) {
+		Config_Key const *entry = config_keys + i;
+
+		if (strcmp(entry->name, key) != 0) {
+			continue;
+		}
+		errno = 0;
+		if (entry->is_double) {
+			double number = strtod(value, &end);
+
+			if (end == value || *end != '\0') {
+				return "bad value";
+			}
+			if (errno == ERANGE || !isfinite(number)) {
+				return "value is out of range";
+			}
+			*(double *)((char *)config + entry->offset) = number;
+		}
+		else {
+			long number = strtol(value, &end, 10);
+
+			if (end == value || *end != '\0') {
+				return "bad value";
+			}
+			if (errno == ERANGE || number < INT_MIN || number > INT_MAX) {
+				return "value is out of range";
+			}
+			*(int *)((char *)config + entry->offset) = (int)number;
+		}
+		return NULL;
+	}
+
+	return "unknown key";
+}
+
+/*apply one "key=value" setting, spaces around key and value are allowed. an unknown key or a bad value is an error*/
+int ga_config_set(GA_Config *config, char const *setting)
+{
+	char const *error = ga_config_apply(config, setting);
+
+	if (error != NULL) {
+		printf("[CONFIG.cpp--ga_config_set--ERROR] %s: \"%s\"\n", error, setting);
+		exit(EXIT_FAILURE);
+	}
+	return EXIT_SUCCESS;
+}
+
+/*apply the settings of a config file, one "key = value" per line. '#' starts a comment*/
+int ga_config_load(GA_Config *config, char const *path)
+{
+	char line[SETTING_SIZE] = "";
+	FILE *file = NULL;
+
+	if ((file = fopen(path, "r")) == NULL) {
+		printf("[CONFIG.cpp--ga_config_load--ERROR] cannot open %s\n", path);
+		exit(EXIT_FAILURE);
+	}
+
+	while (fgets(line, sizeof line, file) != NULL) {
+		char *comment = strchr(line, '#');
+		char *setting = NULL;
+
+		if (comment != NULL) {
+			*comment = '\0';
+		}
+		setting = trim(line);
+		if (*setting != '\0') {
+			ga_config_set(config, setting);
+		}
+	}
+	fclose(file);
+
+	return EXIT_SUCCESS;
+}
+
+/*what is wrong with config: NULL if all values are in range, else the message of the first one which is not*/
+char const *ga_config_error(GA_Config const *config)
+{
+	char const *error = NULL;
+
+	if (config->max_loop < 0) {
+		error = "max_loop must not be negative";
+	}
+	else if (!(config->mutate_rate >= 0.0 && config->mutate_rate <= 1.0)) {	/*written so that NaN fails too*/
+		error = "mutate_rate must be in [0, 1]";
+	}
+	else if (config->cross_method != 1 && config->cross_method != 2) {
+		error = "cross_method must be 1 (point) or 2 (mask)";
+	}
+	else if (config->select_method != 1 && config->select_method != 2) {
+		error = "select_method must be 1 (roulette) or 2 (tournament)";
+	}
+	else if (config->k_candidate < 2 || config->k_candidate > MAX_K_CANDIDATE) {
+		error = "k_candidate is out of range";
+	}
+	else if (config->mask_per_pair != 0 && config->mask_per_pair != 1) {
+		error = "mask_per_pair must be 0 or 1";
+	}
+	else if (config->hybrid < 1 || config->hybrid > 3) {
+		error = "hybrid must be 1 (assessment strategy), 2 (hill climbing) or 3 (tabu search)";
+	}
+	else if (config->tabu_iterations < 0 || config->tabu_tenure < 0 || !(config->tabu_alpha >= 0.0 && isfinite(config->tabu_alpha))) {
+		error = "tabu_iterations, tabu_tenure and tabu_alpha must not be negative, tabu_alpha must be finite";
+	}
+	else if (config->eval_cache != 0 && config->eval_cache != 1) {
+		error = "eval_cache must be 0 or 1";
+	}
+
+	return error;
+}
+
+/*check that all values of config are in range, an error is reported for the first one which is not*/
+int ga_config_check(GA_Config const *config)
+{
+	char const *error = ga_config_error(config);
+
+	if (error != NULL) {
+		printf("[CONFIG.cpp--ga_config_check--ERROR] %s\n", error);
+		exit(EXIT_FAILURE);
+	}
+	return EXIT_SUCCESS;
+}
+
+/*print config as settings which ga_config_load can read back*/
+void ga_config_print(FILE *file, GA_Config const *config)
+{
+	for (size_t i = 0; i < sizeof config_keys / sizeof config_keys[0]; i++) {
+		Config_Key const *entry = config_keys + i;
+
+		if (entry->is_double) {
+			fprintf(file, "%s = %.17g\n", entry->name, *(double const *)((char const *)config + entry->offset));
+		}
+		else {
+			fprintf(file, "%s = %d\n", entry->name, *(int const *)((char const *)config + entry->offset));
+		}
+	}
+}
@@ -0,0 +1,71 @@
+#ifndef _HEADER_CONFIG_H
+#define _HEADER_CONFIG_H	1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+** defaults of the GA parameters. they can be changed at run time by a config file or "key=value" settings,
+** the keys are the lower case names of these macros.
+*/
+#define MAX_LOOP	10000
+#define MUTATE_RATE	0.014
+#define USE_ELITE	1
+#define USE_SCALING	1
+#define CROSS_METHOD	2	/*crossover method.	1--point crossover.	2--mask crossover*/
+#define MASK_PER_PAIR	0	/*mask crossover. 0--one mask per generation. 1--a fresh mask per pair*/
+#define SELECT_METHOD	2	/*select method. 1--roulette select. 2--tournament select*/
+#define K_CANDIDATE	2	/*number of candidate chromosome in tournament select*/
+#define USE_HYBRID	0
+#define HYBRID		2
+#define TABU_ITERATIONS	1000	/*largest number of moves of one tabu search*/
+#define TABU_TENURE	10	/*random part of the tabu tenure is drawn from 0 ... TABU_TENURE - 1*/
+#define TABU_ALPHA	0.6	/*the tabu tenure grows by this many iterations per conflict node*/
+#define EVAL_CACHE	0	/*1--a child equal to a parent takes its fitness instead of being evaluated*/
+
+#define MAX_K_CANDIDATE	16	/*largest number of candidates of tournament select*/
+
+/*operators and parameters of a GA run*/
+typedef struct GA_Config {
+	int max_loop;	/*largest number of generations*/
+	double mutate_rate;	/*probability that a gene mutates*/
+	int use_elite;	/*keep the best parent*/
+	int use_scaling;	/*scale fitness before selection*/
+	int cross_method;	/*1--point crossover.	2--mask crossover*/
+	int mask_per_pair;	/*mask crossover draws a fresh mask for each pair instead of one per generation*/
+	int select_method;	/*1--roulette select. 2--tournament select*/
+	int k_candidate;	/*number of candidates of tournament select, 2 ... MAX_K_CANDIDATE*/
+	int use_hybrid;	/*apply a local search to the best child of each generation*/
+	int hybrid;	/*local search. 1--assessment strategy. 2--hill climbing. 3--tabu search*/
+	int tabu_iterations;	/*largest number of moves of one tabu search*/
+	int tabu_tenure;	/*random part of the tabu tenure*/
+	double tabu_alpha;	/*tabu tenure per conflict node*/
+	int eval_cache;	/*look the children up in a hash table of the parents before they are evaluated*/
+} GA_Config;
+
+/*set config to the default values above*/
+void ga_config_default(GA_Config *config);
+
+/*apply one "key=value" setting, spaces around key and value are allowed. an unknown key or a bad value is an error*/
+int ga_config_set(GA_Config *config, char const *setting);
+
+/*
+** apply one "key=value" setting like ga_config_set, but return what is wrong with it instead of stopping:
+** NULL if it was applied, else a message, and config is not changed.
+*/
+char const *ga_config_apply(GA_Config *config, char const *setting);
+
+/*apply the settings of a config file, one "key = value" per line. '#' starts a comment*/
+int ga_config_load(GA_Config *config, char const *path);
+
+/*what is wrong with config: NULL if all values are in range, else the message of the first one which is not*/
+char const *ga_config_error(GA_Config const *config);
+
+/*check that all values of config are in range, an error is reported for the first one which is not*/
+int ga_config_check(GA_Config const *config);
+
+/*print config as settings which ga_config_load can read back*/
+void ga_config_print(FILE *file, GA_Config const *config);
+
+#endif
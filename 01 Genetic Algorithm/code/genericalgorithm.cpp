@@ -1,230 +1,560 @@
 #include "geneticalgorithm.h"
 
-/*this function is used by qsort function*/
+/*this function is used by qsort function, it sorts fitness values from the best*/
 int f_compare(void const *a, void const *b)
 {
-	return ((Chromosome *)a)->fitnessValue > ((Chromosome *)b)->fitnessValue ? -1 :
-		(((Chromosome *)a)->fitnessValue < ((Chromosome *)b)->fitnessValue ? 1 : 0);
+	return *(double const *)a > *(double const *)b ? -1 :
+		(*(double const *)a < *(double const *)b ? 1 : 0);
 }
 
-/*initialize chromosome list*/
-void initialize(Chromosome *chromo_list, char const(*graph)[NODE_NUMBER])
+/*grow a buffer of a population to bytes, its contents are not kept*/
+static void *population_grow(void *buffer, size_t bytes)
 {
+	free(buffer);
+	if ((buffer = malloc(bytes > 0 ? bytes : 1)) == NULL) {
+		printf("[GENETICALGORITHM.cpp--population_grow--ERROR] cannot allocate memory\n");
+		exit(EXIT_FAILURE);
+	}
+	return buffer;
+}
+
+/*allocate a population of size chromosomes with node_number genes each*/
+void population_init(Population *pop, int size, int node_number)
+{
+	memset(pop, 0, sizeof *pop);
+	population_reserve(pop, size, node_number);
+}
+
+/*
+** make pop a population of size chromosomes with node_number genes each. its buffers are only grown when they are too small,
+** so a population can be reused for graphs of any size. the chromosomes are not initialized. a population set to { 0 } can be passed.
+*/
+void population_reserve(Population *pop, int size, int node_number)
+{
+	size_t genes = (size_t)size * node_number;
+	size_t masks = (size_t)(size / 2 > 0 ? size / 2 : 1) * BIT_WORDS(node_number);
+	int slots = 2;
+
+	/*
+	** the hash table has at least twice as many slots as chromosomes, so a probe soon finds an empty slot.
+	*/
+	while (slots < 2 * size) {
+		slots *= 2;
+	}
+	if (size > pop->capacity) {
+		pop->chromos = (Chromosome *)population_grow(pop->chromos, size * sizeof(Chromosome));
+		pop->fitness = (double *)population_grow(pop->fitness, size * sizeof(double));
+		pop->dirty = (char *)population_grow(pop->dirty, size * sizeof(char));
+		pop->hashes = (uint64_t *)population_grow(pop->hashes, size * sizeof(uint64_t));
+		pop->twins = (int *)population_grow(pop->twins, slots * sizeof(int));
+		pop->conflicts = (int *)population_grow(pop->conflicts, size * sizeof(int));
+		pop->capacity = size;
+	}
+	if (genes > pop->gene_capacity) {
+		pop->genes = (char *)population_grow(pop->genes, genes * sizeof(char));
+		pop->node_conflicts = (int *)population_grow(pop->node_conflicts, genes * sizeof(int));
+		pop->gene_capacity = genes;
+	}
+	if (masks > pop->mask_capacity) {
+		pop->masks = (uint64_t *)population_grow(pop->masks, masks * sizeof(uint64_t));
+		pop->mask_capacity = masks;
+	}
+	pop->size = size;
+	pop->node_number = node_number;
+	pop->twin_mask = slots - 1;
+	pop->cross = select_cross_kernels(node_number);
+	pop->slice = select_slice_kernels(size);
+
+	/*
+	** each chromosome points to its own part of the buffers.
+	*/
+	for (int i = 0; i < size; i++) {
+		pop->chromos[i].solution = pop->genes + (size_t)i * node_number;
+		pop->chromos[i].state.node_conflicts = pop->node_conflicts + (size_t)i * node_number;
+		pop->chromos[i].origin = -1;
+	}
+	memset(pop->dirty, 0, size * sizeof(char));
+}
+
+/*release the memory held by population*/
+void population_free(Population *pop)
+{
+	free(pop->chromos);
+	free(pop->fitness);
+	free(pop->genes);
+	free(pop->node_conflicts);
+	free(pop->masks);
+	free(pop->dirty);
+	free(pop->hashes);
+	free(pop->twins);
+	free(pop->conflicts);
+	free(pop->planes);
+	memset(pop, 0, sizeof *pop);
+}
+
+/*copy chromosome src_index of population src to chromosome dst_index of population dst*/
+void copy_chromosome(Population *dst, int dst_index, Population const *src, int src_index)
+{
+	Chromosome *dst_chromo = dst->chromos + dst_index;
+	Chromosome const *src_chromo = src->chromos + src_index;
+
+	memcpy(dst_chromo->solution, src_chromo->solution, src->node_number * sizeof(char));
+	dst->fitness[dst_index] = src->fitness[src_index];
+	dst->hashes[dst_index] = src->hashes[src_index];
+	dst_chromo->origin = src_chromo->origin;
+	conflict_state_copy(&dst_chromo->state, &src_chromo->state, src->node_number);
+}
+
+/*initialize chromosome list, the random solutions are evaluated together by the bitsliced kernels*/
+void initialize(Population *pop, Graph const *graph, Rng *rng)
+{
+	int *conflicts = pop->conflicts;
+
 	/*
-	** generate candidate solution randomly and calculate fitness value for each chromosome.
+	** the bit planes are only needed here, so they are only allocated for populations which are initialized.
 	*/
-	for (Chromosome *p_chromo = chromo_list; p_chromo < chromo_list + POP_SIZE; p_chromo++) {
-		for (int i = 0; i < NODE_NUMBER; i++) {
-			p_chromo->solution[i] = randi() % 3;
+	if (slice_plane_words(pop->slice, pop->node_number) > pop->plane_capacity) {
+		pop->plane_capacity = slice_plane_words(pop->slice, pop->node_number);
+		pop->planes = (uint64_t *)population_grow(pop->planes, pop->plane_capacity * sizeof(uint64_t));
+	}
+
+	/*
+	** generate candidate solution randomly.
+	*/
+	for (int i = 0; i < pop->size; i++) {
+		random_genes(pop->chromos[i].solution, pop->node_number, rng);
+		pop->chromos[i].origin = -1;
+	}
+
+	/*
+	** the node conflicts of all chromosomes are counted in one walk over the links per block of lanes,
+	** they are written straight into the conflict states, which are laid out like the genes.
+	*/
+	slice_conflicts(pop->slice, graph, pop->genes, pop->size, conflicts, pop->node_conflicts, pop->planes);
+	for (int i = 0; i < pop->size; i++) {
+		Chromosome *p_chromo = pop->chromos + i;
+		p_chromo->state.conflict = conflicts[i];
+		p_chromo->state.total_links = graph->edge_number;
+		pop->fitness[i] = conflict_state_fitness(&p_chromo->state);
+		pop->hashes[i] = gene_hash(p_chromo->solution, pop->node_number);
+	}
+}
+
+/*build the hash table of the chromosomes of pop from their hashes*/
+void population_index(Population *pop)
+{
+	memset(pop->twins, -1, (pop->twin_mask + 1) * sizeof(int));
+
+	/*
+	** open addressing with linear probing. equal chromosomes all get a slot, a lookup stops at the first one.
+	*/
+	for (int i = 0; i < pop->size; i++) {
+		int slot = (int)(pop->hashes[i] & pop->twin_mask);
+
+		while (pop->twins[slot] >= 0) {
+			slot = (slot + 1) & pop->twin_mask;
 		}
-		p_chromo->fitnessValue = fitness(graph, p_chromo->solution);
+		pop->twins[slot] = i;
 	}
 }
 
+/*index of a chromosome of pop whose genes are solution, hash is the gene_hash of solution. return -1 if there is none*/
+int population_find(Population const *pop, char const *solution, uint64_t hash)
+{
+	for (int slot = (int)(hash & pop->twin_mask); pop->twins[slot] >= 0; slot = (slot + 1) & pop->twin_mask) {
+		int i = pop->twins[slot];
+
+		if (pop->hashes[i] == hash && memcmp(pop->chromos[i].solution, solution, pop->node_number) == 0) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
 /*calculate total fitness of population*/
-double total_fitness(Chromosome const *chromo_list)
+double total_fitness(Population const *pop)
 {
 	double total_fitness = 0.0;
-	for (unsigned i = 0; i < POP_SIZE; i++) {
-		total_fitness += chromo_list[i].fitnessValue;
+	for (int i = 0; i < pop->size; i++) {
+		total_fitness += pop->fitness[i];
 	}
 
 	return total_fitness;
 }
 
-/*select a chromosome with*/
-unsigned int roulette_selection(Chromosome const *chromo_list, double sum_fitness)
+/*allocate an alias table for populations of size chromosomes*/
+void alias_table_init(Alias_Table *table, int size)
 {
-	unsigned int selected_index = 0;
-	double accumulate = 0.0;
-	double criteria = 0.0;
-
-	criteria = randf() * sum_fitness;
-
-	for (unsigned i = 0; i < POP_SIZE; i++) {
-		accumulate += chromo_list[i].fitnessValue;
-		if (accumulate >= criteria) {
-			selected_index = i; break;
-		}
+	table->size = size;
+	table->capacity = size;
+	table->prob = (double *)malloc(size * sizeof(double));
+	table->alias = (int *)malloc(size * sizeof(int));
+	table->work = (int *)malloc(size * sizeof(int));
+
+	if (table->prob == NULL || table->alias == NULL || table->work == NULL) {
+		printf("[GENETICALGORITHM.cpp--alias_table_init--ERROR] cannot allocate memory\n");
+		exit(EXIT_FAILURE);
 	}
+}
 
-	return selected_index;
+/*release the memory held by an alias table*/
+void alias_table_free(Alias_Table *table)
+{
+	free(table->prob);
+	free(table->alias);
+	free(table->work);
+	memset(table, 0, sizeof *table);
 }
 
-/*select a chromosome with tournament*/
-unsigned int tournament_selection(Chromosome const *chromo_list) 
+/*
+** build the roulette of size weights in O(size), chromosome i is picked with probability weights[i] / total.
+** if fewer than two weights are positive, the picks are uniform, so two different chromosomes can always be selected.
+*/
+void alias_table_build(Alias_Table *table, double const *weights, int size)
 {
-	unsigned int selected_chromo_indices[K_CANDIDATE] = { 0 };
-	unsigned int best_index;
-	double best_fitness;
-	
+	double total = 0.0;
+	int positive = 0;
+	int small_len = 0;	/*slots below the mean are work[0] ... work[small_len - 1]*/
+	int large_first = size;	/*slots at or above the mean are work[large_first] ... work[size - 1]*/
+	int *work = table->work;
+
+	table->size = size;
+	for (int i = 0; i < size; i++) {
+		total += weights[i];
+		positive += weights[i] > 0.0;
+	}
+
+	if (positive < 2) {
+		for (int i = 0; i < size; i++) {
+			table->prob[i] = 1.0;
+			table->alias[i] = i;
+		}
+		return;
+	}
+
 	/*
-	** select k candidate chromosomes from gene pool randomly. make sure they are different from each other.
+	** scale the weights to a mean of 1. each slot below the mean is filled up by a slot above it,
+	** which then loses what it gave and may fall below the mean itself.
 	*/
-	while (1) {
-		int distinct = 1;
-		
-		for (int i = 0; i < K_CANDIDATE; i++) {
-			selected_chromo_indices[i] = randi() % POP_SIZE;
+	for (int i = 0; i < size; i++) {
+		table->prob[i] = weights[i] * size / total;
+		table->alias[i] = i;
+		if (table->prob[i] < 1.0) {
+			work[small_len++] = i;
+		}
+		else {
+			work[--large_first] = i;
 		}
+	}
 
-		/*
-		** check if there are two same indices.
-		*/
-		for (int i = 0; i < K_CANDIDATE - 1; i++) {
-			for (int j = i + 1; j < K_CANDIDATE; j++) {
-				if (selected_chromo_indices[i] == selected_chromo_indices[j]) {
-					distinct = 0; break;
-				}
-			}
-			if (distinct == 0) break;
+	while (small_len > 0 && large_first < size) {
+		int small = work[--small_len];
+		int large = work[large_first];
+
+		table->alias[small] = large;
+		table->prob[large] -= 1.0 - table->prob[small];
+		if (table->prob[large] < 1.0) {
+			large_first += 1;
+			work[small_len++] = large;
 		}
+	}
 
-		if (distinct == 1) break;	/*if all indices are different, break out while statement*/
+	/*the slots left over are full up to rounding*/
+	while (small_len > 0) {
+		table->prob[work[--small_len]] = 1.0;
+	}
+	while (large_first < size) {
+		table->prob[work[large_first++]] = 1.0;
 	}
+}
+
+/*select a chromosome with roulette, table is built from the fitness of the population*/
+unsigned int roulette_selection(Alias_Table const *table, Rng *rng)
+{
+	int slot = rng_below(rng, table->size);
+
+	return rng_double(rng) < table->prob[slot] ? (unsigned int)slot : (unsigned int)table->alias[slot];
+}
+
+/*
+** select a chromosome with tournament. K > 0 fixes the number of candidates at compile time,
+** K == 0 takes it from k_candidate.
+*/
+template <int K>
+static inline unsigned int tournament_pick(Population const *pop, int k_candidate, Rng *rng)
+{
+	int const k = K > 0 ? K : k_candidate;
+	int slots[K > 0 ? K : MAX_K_CANDIDATE];	/*slots of the shuffle which were swapped ...*/
+	int values[K > 0 ? K : MAX_K_CANDIDATE];	/*... and the indices they hold now*/
+	int moved = 0;
+	unsigned int best_index = 0;
+	double best_fitness = -1.0;
 
 	/*
-	** select the best chromosome in k candidates
+	** draw k different candidates by the first k steps of a Fisher-Yates shuffle of 0 ... size - 1, so nothing is drawn again.
+	** the shuffle is not stored: the few swapped slots are kept in a list, every other slot still holds its own index.
+	** slot i is never read after step i, so only slot r needs to be updated.
 	*/
-	best_index = selected_chromo_indices[0];
-	best_fitness = chromo_list[selected_chromo_indices[0]].fitnessValue;
-	for (int i = 1; i < K_CANDIDATE; i++) {
-		if (chromo_list[selected_chromo_indices[i]].fitnessValue > best_fitness) {
-			best_index = selected_chromo_indices[i];
-			best_fitness = chromo_list[selected_chromo_indices[i]].fitnessValue;
+	for (int i = 0; i < k; i++) {
+		int r = i + rng_below(rng, pop->size - i);
+		int candidate = r;
+		int at_i = i;
+		int m = 0;
+
+		for (int j = 0; j < moved; j++) {
+			if (slots[j] == r) {
+				candidate = values[j];
+			}
+			if (slots[j] == i) {
+				at_i = values[j];
+			}
+		}
+		while (m < moved && slots[m] != r) {
+			m++;
+		}
+		slots[m] = r;
+		values[m] = at_i;
+		moved += m == moved;
+
+		/*
+		** the best of the candidates in the order they are drawn
+		*/
+		if (pop->fitness[candidate] > best_fitness) {
+			best_index = candidate;
+			best_fitness = pop->fitness[candidate];
 		}
 	}
 
 	return best_index;
 }
 
+/*select a chromosome with tournament of k_candidate different chromosomes*/
+unsigned int tournament_selection(Population const *pop, int k_candidate, Rng *rng)
+{
+	return k_candidate == 2 ? tournament_pick<2>(pop, 2, rng) : tournament_pick<0>(pop, k_candidate, rng);
+}
+
 /*
-**crossover chromosomes and generate children population. you should choose a crossover method by macro.
-**	1--point crossover
-**	2--mask crossover
+** crossover pipeline of one operator set. SELECT is the select method, K the number of tournament candidates
+** (0 means config->k_candidate) and CROSS the crossover method. they are template arguments, so the switches
+** below are resolved by the compiler and the loop over the pairs has no branch on the operators.
 */
-void crossover(Chromosome const *parent_chromo_list, Chromosome *children_chromo_list)
+template <int SELECT, int K, int CROSS>
+static void crossover_pairs(GA_Config const *config, Population const *parents, Population *children, int first_pair, int last_pair,
+	Alias_Table const *roulette, Rng *rng, Profile *profile)
 {
 	int crossover_position;
-	Chromosome chromo;
-	chromo.fitnessValue = 0.0;
-	int mask[NODE_NUMBER] = { 0, };
-	double sum_fitness = total_fitness(parent_chromo_list);
-
-	/*generate mask*/
-	for (int i = 0; i < NODE_NUMBER; i++) {
-		mask[i] = randi() % 2;
-	}
+	int node_number = parents->node_number;
+	int k_candidate = config->k_candidate;
+	int mask_words = BIT_WORDS(node_number);
+	size_t mask_stride = config->mask_per_pair ? (size_t)mask_words : 0;	/*pair i crosses with masks + i * mask_stride*/
+	uint64_t *masks = children->masks;
+	Chromosome const *parent_chromo_list = parents->chromos;
+	Chromosome *children_chromo_list = children->chromos;
+	unsigned int selected[2 * CHUNK_PAIRS];	/*parents of the pairs of a batch*/
+	PROFILE_MARK(mark);
 
 	/*
-	** generate children population by crossover
+	** the pairs are bred in batches of CHUNK_PAIRS: all parents of a batch are selected first, then the batch is crossed over.
 	*/
-	for (int i = 0; i < POP_SIZE / 2; i++) {
-		unsigned int chromo_index_1 = 0;
-		unsigned int chromo_index_2 = 0;
+	for (int batch = first_pair; batch < last_pair; batch += CHUNK_PAIRS) {
+		int batch_end = batch + CHUNK_PAIRS < last_pair ? batch + CHUNK_PAIRS : last_pair;
+
+		/*
+		** select two different chromosome frome parent chromosome list. a pair with the same parent twice is drawn again as a whole,
+		** which keeps the chance of each pair in proportion to the chances of its parents. a draw costs O(1) or O(k).
+		*/
+		for (int i = batch; i < batch_end; i++) {
+			unsigned int *pair = selected + 2 * (i - batch);
+
+			do {
+				switch (SELECT)
+				{
+				case 1:	/*roulette selection*/
+					pair[0] = roulette_selection(roulette, rng);
+					pair[1] = roulette_selection(roulette, rng);
+
+					break;
+
+				case 2:	/*tournament selection*/
+					pair[0] = tournament_pick<K>(parents, k_candidate, rng);
+					pair[1] = tournament_pick<K>(parents, k_candidate, rng);
+
+					break;
+				default:
+					break;
+				}
+			} while (pair[0] == pair[1]);
+		}
+		PROFILE_LAP(profile, PHASE_SELECTION, mark);
 
 		/*
-		** select two different chromosome frome parent chromosome list.
+		** a mask per pair: the rows of the pairs of a batch follow each other, so all their masks are drawn in one go.
 		*/
-		while (1) {
-			switch (SELECT_METHOD)
+		if (CROSS == 2 && mask_stride != 0) {
+			random_mask(masks + (size_t)batch * mask_words, (batch_end - batch) * mask_words * 64, rng);
+		}
+
+		for (int i = batch; i < batch_end; i++) {
+			unsigned int chromo_index_1 = selected[2 * (i - batch)];
+			unsigned int chromo_index_2 = selected[2 * (i - batch) + 1];
+			int changed = 0;	/*the children are not copies of their parents*/
+
+			/*
+			** each child mostly inherits the genes of the parent it starts with.
+			*/
+			children_chromo_list[2 * i].origin = chromo_index_1;
+			children_chromo_list[2 * i + 1].origin = chromo_index_2;
+
+			switch (CROSS)
 			{
-			case 1:	/*roulette selection*/
-				chromo_index_1 = roulette_selection(parent_chromo_list, sum_fitness);
-				chromo_index_2 = roulette_selection(parent_chromo_list, sum_fitness);
-				
+			case 1:	/*point crossover*/
+
+				/*choose a crossover point, it is neither the first nor the last gene*/
+				crossover_position = 1 + rng_below(rng, node_number - 2);
+
+				changed = point_crossover(crossover_position,
+					parent_chromo_list[chromo_index_1].solution, parent_chromo_list[chromo_index_2].solution,
+					children_chromo_list[2 * i].solution, children_chromo_list[2 * i + 1].solution, node_number);
+
 				break;
 
-			case 2:	/*tournament selection*/
-				chromo_index_1 = tournament_selection(parent_chromo_list);
-				chromo_index_2 = tournament_selection(parent_chromo_list);
+			case 2:	/*mask crossover*/
+
+				changed = parents->cross->mask_crossover(masks + i * mask_stride,
+					parent_chromo_list[chromo_index_1].solution, parent_chromo_list[chromo_index_2].solution,
+					children_chromo_list[2 * i].solution, children_chromo_list[2 * i + 1].solution, node_number);
 
 				break;
+
 			default:
 				break;
-			}
-			/*
-			** make sure that two indices are different.
-			*/
-			if (chromo_index_1 != chromo_index_2)
-				break;
+			}	/*end of switch (CROSS)*/
+			children->dirty[2 * i] = (char)changed;
+			children->dirty[2 * i + 1] = (char)changed;
 		}
+		PROFILE_LAP(profile, PHASE_CROSSOVER, mark);
 
-		switch (CROSS_METHOD)
-		{
-		case 1:	/*point crossover*/
+	}	/*end of for (int batch = first_pair; batch < last_pair; batch += CHUNK_PAIRS)*/
+}
 
-			/*choose a crossover point*/
-			while (1) {
-				crossover_position = randi() % NODE_NUMBER;
-				if (crossover_position != 0 && crossover_position != NODE_NUMBER - 1)
-					break;
-			}
+/*
+** the operator sets which get their own pipeline: (select method, tournament candidates, crossover method).
+** tournaments of 2 candidates are the default and get a fixed size, other sizes share one pipeline.
+*/
+#define PIPELINES(X)	X(1, 0, 1) X(1, 0, 2) X(2, 2, 1) X(2, 2, 2) X(2, 0, 1) X(2, 0, 2)
 
-			for (int j = 0; j < NODE_NUMBER; j++) {
-				if (j < crossover_position) {
-					children_chromo_list[2 * i].solution[j] = parent_chromo_list[chromo_index_1].solution[j];
-					children_chromo_list[2 * i + 1].solution[j] = parent_chromo_list[chromo_index_2].solution[j];
-				}
-				else {
-					children_chromo_list[2 * i].solution[j] = parent_chromo_list[chromo_index_2].solution[j];
-					children_chromo_list[2 * i + 1].solution[j] = parent_chromo_list[chromo_index_1].solution[j];
-				}
-			}
+/*index of the pipeline of config in the tables below, in the order of PIPELINES*/
+static int pipeline_index(GA_Config const *config)
+{
+	int select = config->select_method == 1 ? 0 : config->k_candidate == 2 ? 1 : 2;
 
-			break;
+	return 2 * select + config->cross_method - 1;
+}
 
-		case 2:	/*mask crossover*/
+typedef void(*Crossover_Func)(GA_Config const *config, Population const *parents, Population *children, int first_pair, int last_pair,
+	Alias_Table const *roulette, Rng *rng, Profile *profile);
 
-			for (int j = 0; j < NODE_NUMBER; j++) {			
-				if (mask[j] == 0) {	/*if mask == 0, ...*/
-					children_chromo_list[2 * i].solution[j] = parent_chromo_list[chromo_index_1].solution[j];
-					children_chromo_list[2 * i + 1].solution[j] = parent_chromo_list[chromo_index_2].solution[j];
-				}
-				else {	/*if mask == 1, ...*/
-					children_chromo_list[2 * i].solution[j] = parent_chromo_list[chromo_index_2].solution[j];
-					children_chromo_list[2 * i + 1].solution[j] = parent_chromo_list[chromo_index_1].solution[j];
-				}
-			}
+#define CROSSOVER_ENTRY(select, k, cross)	crossover_pairs<select, k, cross>,
 
-			break;
+static Crossover_Func const crossover_table[] = {
+	PIPELINES(CROSSOVER_ENTRY)
+};
 
-		default:
-			break;
-		}	/*end of switch (CROSS_METHOD)*/
+/*
+**crossover chromosomes and generate the children pairs first_pair ... last_pair - 1. the crossover and select methods are taken from config.
+**	1--point crossover
+**	2--mask crossover
+** mask crossover uses the first mask of children population, or draws a mask per pair into its row if config->mask_per_pair is set. roulette is the alias table of parents (only read by roulette selection).
+** selection and crossover times are added to profile, it may be NULL.
+*/
+void crossover(GA_Config const *config, Population const *parents, Population *children, int first_pair, int last_pair,
+	Alias_Table const *roulette, Rng *rng, Profile *profile)
+{
+	crossover_table[pipeline_index(config)](config, parents, children, first_pair, last_pair, roulette, rng, profile);
+}
 
-	}	/*end of for (int i = 0; i < POP_SIZE / 2; i++)*/
+/*mutate chromosomes first ... last - 1 to a new type*/
+void mutation(Population *pop, int first, int last, double m_rate, Rng *rng)
+{
+	/*
+	** the genes of chromosomes first ... last - 1 are one block of the gene buffer, so they are mutated as one run of genes.
+	*/
+	mutate_genes(pop->genes + (size_t)first * pop->node_number, (long long)(last - first) * pop->node_number, m_rate, rng,
+		pop->node_number, pop->dirty + first);
 }
 
+/*evaluate a child chromosome and return its fitness. if it is close to its origin parent, the parent's conflict state is updated to it incrementally*/
+double evaluate_chromosome(Graph const *graph, Population const *parents, Chromosome *chromo)
+{
+	Chromosome const *origin = NULL;
+	int limit = (int)(parents->node_number * REBASE_RATE);
+	int diff = 0;
+
+	/*
+	** count the genes which differ from the origin parent, a far child is cheaper to evaluate from scratch.
+	*/
+	if (chromo->origin >= 0) {
+		origin = parents->chromos + chromo->origin;
+		diff = count_diff(origin->solution, chromo->solution, limit, parents->node_number);
+	}
+
+	if (origin != NULL && diff <= limit) {
+		conflict_state_rebase(graph, origin->solution, &origin->state, chromo->solution, &chromo->state);
+	}
+	else {
+		conflict_state_init(graph, chromo->solution, &chromo->state);
+	}
 
+	return conflict_state_fitness(&chromo->state);
+}
 
-/*mutate chromosome to a new type*/
-void mutation(Chromosome *chromo_list, double m_rate)
+/*
+** set the conflict state and the fitness of child index of children. a clean child takes the state of its origin parent,
+** with use_cache a dirty child which is equal to a parent takes the state of that parent, only the others are evaluated.
+** return 1 if the child was evaluated, 0 if the evaluation was avoided.
+*/
+int assess_child(Graph const *graph, Population const *parents, Population *children, int index, int use_cache)
 {
-	char new_color = 0;
-	for (Chromosome *p_chromo = chromo_list; p_chromo < chromo_list + POP_SIZE; p_chromo++) {
-		for (int i = 0; i < NODE_NUMBER; i++) {
-			if (randf() <= m_rate) {
-				/*
-				** we should select a new color which is different from the current one.
-				*/
-				while ((new_color = randi() % 3) == p_chromo->solution[i])
-					;
-				p_chromo->solution[i] = new_color;
-			}
+	Chromosome *chromo = children->chromos + index;
+	int twin = chromo->origin;
+	uint64_t hash = 0;
+
+	/*
+	** a dirty child is looked up among the parents, the hash table is built by the run before breeding.
+	*/
+	if (children->dirty[index]) {
+		twin = -1;
+		if (use_cache) {
+			hash = gene_hash(chromo->solution, children->node_number);
+			twin = population_find(parents, chromo->solution, hash);
 		}
 	}
+	else if (use_cache) {
+		hash = parents->hashes[twin];
+	}
+	children->hashes[index] = hash;
+
+	if (twin >= 0) {
+		conflict_state_copy(&chromo->state, &parents->chromos[twin].state, children->node_number);
+		children->fitness[index] = conflict_state_fitness(&chromo->state);
+		return 0;
+	}
+
+	children->fitness[index] = evaluate_chromosome(graph, parents, chromo);
+	return 1;
 }
 
 /*select the best solution in the current population*/
-unsigned select_elite(Chromosome const *chromo_list)
+unsigned select_elite(Population const *pop)
 {
 	double best_fit = 0.0;
 	unsigned int best_index = 0;
 
-	for (unsigned i = 0; i < POP_SIZE; i++) {
-		if (chromo_list[i].fitnessValue > best_fit) {
-			best_fit = chromo_list[i].fitnessValue;
+	for (int i = 0; i < pop->size; i++) {
+		if (pop->fitness[i] > best_fit) {
+			best_fit = pop->fitness[i];
 			best_index = i;
 		}
 	}
@@ -234,99 +564,108 @@ unsigned select_elite(Chromosome const *chromo_list)
 }
 
 /*assessment strategy is a local search algorithm. hybrid number: 1*/
-int assessment_strategy(char const (*graph)[NODE_NUMBER], Chromosome *chromo)
+int assessment_strategy(Graph const *graph, Chromosome *chromo)
 {
-	Chromosome tmp_chromo = *chromo;	/*by using temp firefly, the current firefly will not be affected*/
-	int flag_change = 0;	/*fitness has been improved (1) or not (0)*/
+	Conflict_State *state = &chromo->state;	/*conflict state is kept up to date with the chromosome*/
 	int eval_times = 0;	/*how many times to calculate the fitness*/
-	Conflict_Infor conflict_infor;	/*conflict list is used to record the conflict number for each node*/
-	int max_conflict_index = 0;
+	int max_conflict = 0;
+	int max_conflict_index = -1;
 
 	/*
 	** find the max conflict node.
 	*/
-	max_conflict_index = solution_conflict(graph, tmp_chromo.solution, &conflict_infor);
+	for (int i = 0; i < graph->node_number; i++) {
+		if (state->node_conflicts[i] > max_conflict) {
+			max_conflict = state->node_conflicts[i];
+			max_conflict_index = i;
+		}
+	}
+
+	if (max_conflict_index < 0) {
+		return eval_times;
+	}
 
 	/*
 	** convert the max conflict node to some other color, and check whether the fitness value is improved or not.
 	*/
 	for (char color = 0; color < 3; color++) {
 		if (color != chromo->solution[max_conflict_index]) {
-			tmp_chromo.solution[max_conflict_index] = color;
-			tmp_chromo.fitnessValue = fitness(graph, tmp_chromo.solution);
 			eval_times += 1;
-			if (tmp_chromo.fitnessValue >= chromo->fitnessValue) {
-				flag_change = 1; break;
+			if (conflict_state_delta(graph, chromo->solution, state, max_conflict_index, color) <= 0) {
+				/*
+				** update current chromosome if found a solution which is not worse.
+				*/
+				conflict_state_recolor(graph, chromo->solution, state, max_conflict_index, color);
+				break;
 			}
 		}
 	}
 
-	/*
-	** update current firefly if found a better solution.
-	*/
-	if (flag_change == 1) {
-		*chromo = tmp_chromo;
-	}
-
 	/*return times of calling fitness function.*/
 	return eval_times;
 }
 
 
 /*hill climbing is a local search algorithm. hybrid number: 2*/
-int hill_climbing(char const (*graph)[NODE_NUMBER], Chromosome *current_chromo)
+int hill_climbing(Graph const *graph, Chromosome *current_chromo, Rng *rng)
 {
-	Chromosome tmp_chromo = *current_chromo;	/*by using temp chromosome, the current chromosome will not be affected*/
+	Conflict_State *state = &current_chromo->state;	/*conflict state is kept up to date with the chromosome*/
 	int eval_times = 0;	/*how many times to calculate the fitness*/
-	Conflict_Infor conflict_infor;	/*conflict infor is used to record the conflict number for each node*/
-	int max_conflict_index = 0;
+	int len = 0;	/*the number of nodes whose conflict is not 0*/
 	int selected_index = 0;
-	int flag_found = 0;
 
 	int count = 0;
 	while (count < MAX_HILLCLIMB) {
 
 		/*
-		** compute conflict list, see problem.cpp for details
+		** count conflict nodes in the conflict state
 		*/
-		max_conflict_index = solution_conflict(graph, tmp_chromo.solution, &conflict_infor);
+		len = 0;
+		for (int i = 0; i < graph->node_number; i++) {
+			if (state->node_conflicts[i] > 0) {
+				len += 1;
+			}
+		}
 
 		/*if no conflict, we found a solution*/
-		if (conflict_infor.len == 0) {
-			flag_found = 1;
+		if (len == 0) {
 			break;	/*break while*/
 		}
 
 		/*
 		** randomly select a node whose conflict is not 0
 		*/
-		selected_index = conflict_infor.conflict_nodes[randi() % conflict_infor.len];
+		len = rng_below(rng, len);
+		for (int i = 0; i < graph->node_number; i++) {
+			if (state->node_conflicts[i] > 0) {
+				if (len == 0) {
+					selected_index = i; break;
+				}
+				len -= 1;
+			}
+		}
 
 		/*
 		** convert the current selected node to some other color, and check whether the fitness value is improved or not.
 		*/
 		for (char color = 0; color < 3; color++) {
 			if (color != current_chromo->solution[selected_index]) {
-				tmp_chromo.solution[selected_index] = color;
-				tmp_chromo.fitnessValue = fitness(graph, tmp_chromo.solution);
 				eval_times += 1;
 
 				/*
-				** if new fitness if better than old one, update current firefly
+				** if new fitness if better than old one, update current chromosome
 				*/
-				if (tmp_chromo.fitnessValue > current_chromo->fitnessValue) {
-					current_chromo->solution[selected_index] = tmp_chromo.solution[selected_index];
-					current_chromo->fitnessValue = tmp_chromo.fitnessValue;
+				if (conflict_state_delta(graph, current_chromo->solution, state, selected_index, color) < 0) {
+					conflict_state_recolor(graph, current_chromo->solution, state, selected_index, color);
 				}
 
-				if (tmp_chromo.fitnessValue == 1.0) {
-					flag_found = 1;
+				if (state->conflict == 0) {
 					break;	/*break for*/
 				}
 			}
 		}
 
-		if (flag_found == 1) break;	/*break while*/
+		if (state->conflict == 0) break;	/*break while*/
 
 		count += 1;
 	}
@@ -334,25 +673,31 @@ int hill_climbing(char const (*graph)[NODE_NUMBER], Chromosome *current_chromo)
 	return eval_times;
 }
 
+/*tabu search (TabuCol) is a local search algorithm, the tabu parameters are taken from config. hybrid number: 3*/
+int tabu_col(Graph const *graph, Chromosome *chromo, Tabu_Search *tabu, GA_Config const *config, Rng *rng)
+{
+	return tabu_search(tabu, graph, chromo->solution, &chromo->state, config->tabu_iterations, config->tabu_tenure, config->tabu_alpha, rng);
+}
+
 /*scaling fitness*/
-void scaling(Chromosome *chromo_list)
+void scaling(Population *pop)
 {
+	double *fitness = pop->fitness;
 	double max_fitness = 0.0;
 	double min_fitness = 1.0;
 
-	for (int i = 0; i < POP_SIZE; i++) {
-		if (chromo_list[i].fitnessValue > max_fitness) {
-			max_fitness = chromo_list[i].fitnessValue;
+	for (int i = 0; i < pop->size; i++) {
+		if (fitness[i] > max_fitness) {
+			max_fitness = fitness[i];
 		}
-		if (chromo_list[i].fitnessValue < min_fitness) {
-			min_fitness = chromo_list[i].fitnessValue;
+		if (fitness[i] < min_fitness) {
+			min_fitness = fitness[i];
 		}
 	}
 
 	if (min_fitness != max_fitness) {
-		for (int i = 0; i < POP_SIZE; i++) {
-			double current_fitness = chromo_list[i].fitnessValue;
-			chromo_list[i].fitnessValue = (current_fitness - min_fitness) / (max_fitness - min_fitness);
+		for (int i = 0; i < pop->size; i++) {
+			fitness[i] = (fitness[i] - min_fitness) / (max_fitness - min_fitness);
 		}
 	}
 }
@@ -376,55 +721,340 @@ void elapsed_times(time_t const *start_time, time_t const *end_time, char *used_
 	sprintf(used_time, "%5d hour(s) %4d minute(s) %4d second(s)", hours, minutes, seconds);
 }
 
-/*genetic algorithm*/
-Result *genetic_algorithm(char const (*graph)[NODE_NUMBER])
+/*convert time to a string in the format of ctime. unlike ctime, it writes to buffer, so several threads can call it*/
+void time_to_string(time_t const *t, char *buffer, size_t size)
 {
-	Chromosome parents[POP_SIZE];
-	Chromosome children[POP_SIZE];
+	struct tm local;
+
+#ifdef _WIN32
+	localtime_s(&local, t);
+#else
+	localtime_r(t, &local);
+#endif
+	strftime(buffer, size, "%a %b %d %H:%M:%S %Y\n", &local);
+}
+
+/*
+** breed the pairs of one chunk: select parents, crossover, mutate, keep the elite and evaluate the children. phase times go to profile.
+** it is the pipeline of one operator set, see crossover_pairs.
+*/
+template <int SELECT, int K, int CROSS>
+static void breed_chunk(Generation const *gen, Breed_Task *task)
+{
+	Population *children = gen->children;
+	Profile *profile = &task->profile;
+	int chunk = task->chunk;
+	int first_pair = chunk * CHUNK_PAIRS;
+	int last_pair = first_pair + CHUNK_PAIRS < children->size / 2 ? first_pair + CHUNK_PAIRS : children->size / 2;
+	Rng *rng = gen->streams + chunk;
+
+	crossover_pairs<SELECT, K, CROSS>(gen->config, gen->parents, children, first_pair, last_pair, gen->roulette, rng, profile);
+	PROFILE_MARK(mark);
+	mutation(children, 2 * first_pair, 2 * last_pair, gen->config->mutate_rate, rng);
+	PROFILE_LAP(profile, PHASE_MUTATION, mark);
+
+	/*
+	** keep parents' elite, it replaces the child in its slot. only its genes are copied,
+	** it is clean, so its conflict state is taken from the parent below.
+	*/
+	if (gen->elite >= 2 * first_pair && gen->elite < 2 * last_pair) {
+		memcpy(children->chromos[gen->elite].solution, gen->parents->chromos[gen->elite].solution, children->node_number);
+		children->chromos[gen->elite].origin = gen->elite;
+		children->dirty[gen->elite] = 0;
+		PROFILE_LAP(profile, PHASE_ELITE, mark);
+	}
+
+	/*
+	** only the children which are not copies of a parent are evaluated.
+	*/
+	task->evaluated = 0;
+	for (int i = 2 * first_pair; i < 2 * last_pair; i++) {
+		task->evaluated += assess_child(gen->graph, gen->parents, children, i, gen->use_cache);
+	}
+	task->avoided = 2 * (last_pair - first_pair) - task->evaluated;
+	PROFILE_COUNT(profile, evaluations, task->evaluated);
+	PROFILE_COUNT(profile, avoided, task->avoided);
+	PROFILE_LAP(profile, PHASE_EVALUATION, mark);
+}
 
-	unsigned int parent_best = 0;	/*the index of current best chromosome*/
+#define BREED_ENTRY(select, k, cross)	breed_chunk<select, k, cross>,
 
-	Result *result_record = (Result *)malloc(sizeof Result);
+/*breeding pipelines in the order of PIPELINES*/
+static Breed_Func const breed_table[] = {
+	PIPELINES(BREED_ENTRY)
+};
+
+/*run the breeding pipeline of a chunk on a worker of the pool*/
+static void breed_task(void *arg, int worker)
+{
+	Breed_Task *task = (Breed_Task *)arg;
+	(void)worker;
+	task->gen->breed(task->gen, task);
+}
+
+/*breed and evaluate all children of a generation, the chunks are run on pool if it is not NULL. each task keeps the profile and the evaluations of its chunk*/
+static void breed_generation(Generation *gen, Breed_Task *tasks, Rng *rng, Thread_Pool *pool)
+{
+	/*
+	** the mask of the generation and the chunk streams are drawn from the run's stream in a fixed order before any chunk starts.
+	*/
+	if (!gen->config->mask_per_pair) {
+		random_mask(gen->children->masks, gen->children->node_number, rng);
+	}
+	for (int c = 0; c < gen->chunk_number; c++) {
+		rng_derive(rng, gen->streams + c);
+		tasks[c].gen = gen;
+		tasks[c].chunk = c;
+	}
+
+	if (pool == NULL) {
+		for (int c = 0; c < gen->chunk_number; c++) {
+			gen->breed(gen, tasks + c);
+		}
+		return;
+	}
+
+	for (int c = 0; c < gen->chunk_number; c++) {
+		thread_pool_submit(pool, breed_task, tasks + c);
+	}
+	thread_pool_wait(pool);
+}
+
+/*allocate a result record with room for trace_len change points and a solution of node_number genes, one free() releases all*/
+Result *result_create(int node_number, int trace_len)
+{
+	Result *result_record = (Result *)malloc(sizeof(Result) + trace_len * sizeof(Trace_Point) + node_number);
 	if (result_record == NULL) {
-		printf("cannot allocate memory\n");
+		printf("[GENETICALGORITHM.cpp--result_create--ERROR] cannot allocate memory\n");
 		exit(EXIT_FAILURE);
 	}
+	result_record->trace_len = trace_len;
+	result_record->trace = (Trace_Point *)(result_record + 1);
+	result_record->node_number = node_number;
+	result_record->solution = (char *)(result_record->trace + trace_len);
+	profile_clear(&result_record->profile);
 
-	double gbest = 0.0;	/*the global best fitness*/
-	int count = 0;
-	double eval_times = 0.0;	/*evaluation times of object function*/
-	double gbest_list[MAX_LOOP] = { 0.0 };	/*record all global best fitness value*/
-	char current_best_solution[NODE_NUMBER];
+	return result_record;
+}
+
+/*initialize a run: allocate its populations, generate the first parents and select the best one. config NULL means the defaults*/
+void ga_run_init(GA_Run *run, Graph const *graph, int pop_size, GA_Config const *config, Rng *rng, Thread_Pool *pool)
+{
+	memset(run, 0, sizeof *run);
+	ga_run_restart(run, graph, pop_size, config, rng, pool);
+}
+
+/*
+** initialize a run again, maybe on another graph with another population size and config. the buffers of the run are kept
+** and only grown when they are too small, so a service solving many graphs allocates almost nothing per graph.
+** a run released by ga_run_free can be passed. the run is the same as one of ga_run_init.
+*/
+void ga_run_restart(GA_Run *run, Graph const *graph, int pop_size, GA_Config const *config, Rng *rng, Thread_Pool *pool)
+{
+	int chunk_number = (pop_size / 2 + CHUNK_PAIRS - 1) / CHUNK_PAIRS;
+
+	/*
+	** the run keeps its own copy of config, and its breeding pipeline is chosen here once for all generations.
+	** gen points to the copy, so a run must not be moved once it is initialized.
+	*/
+	if (config != NULL) {
+		run->config = *config;
+	}
+	else {
+		ga_config_default(&run->config);
+	}
+	ga_config_check(&run->config);
+	run->gen.config = &run->config;
+	run->gen.breed = breed_table[pipeline_index(&run->config)];
+
+	run->graph = graph;
+	run->rng = rng;
+	run->pool = pool;
+	if (chunk_number > run->chunk_capacity) {
+		free(run->tasks);
+		free(run->gen.streams);
+		run->tasks = (Breed_Task *)malloc(chunk_number * sizeof(Breed_Task));
+		run->gen.streams = (Rng *)malloc(chunk_number * sizeof(Rng));
+		run->chunk_capacity = chunk_number;
+
+		if (run->tasks == NULL || run->gen.streams == NULL) {
+			printf("[GENETICALGORITHM.cpp--ga_run_restart--ERROR] cannot allocate memory\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	memset(run->tasks, 0, chunk_number * sizeof(Breed_Task));
+	run->gen.chunk_number = chunk_number;
+
+	/*
+	** initialize parents, then select the best one.
+	*/
+	population_reserve(run->pops, pop_size, graph->node_number);
+	population_reserve(run->pops + 1, pop_size, graph->node_number);
+	run->parents = run->pops;
+	run->children = run->pops + 1;
+	initialize(run->parents, graph, rng);
+	run->parent_best = select_elite(run->parents);
+	run->gbest = run->parents->fitness[run->parent_best];
+	run->eval_times = 0.0;
+	run->avoided_times = 0.0;
+	run->count = 0;
+	if (run->trace.points == NULL) {
+		trace_init(&run->trace, TRACE_STRIDE);
+	}
+	trace_clear(&run->trace);
+	trace_add(&run->trace, 0, run->eval_times, run->gbest);
+	profile_clear(&run->profile);
+	run->profile.runs = 1;
+
+	/*
+	** the roulette and the tabu workspace are kept if they are large enough for this population and graph.
+	*/
+	if (run->config.select_method == 1 && run->roulette.capacity < pop_size) {
+		alias_table_free(&run->roulette);
+		alias_table_init(&run->roulette, pop_size);
+	}
+	if (run->config.use_hybrid && run->config.hybrid == 3) {
+		if (run->tabu.node_number < graph->node_number) {
+			tabu_free(&run->tabu);
+			tabu_init(&run->tabu, graph->node_number);
+		}
+		tabu_reset(&run->tabu);
+	}
+}
+
+/*evolve a run by one generation: breed and evaluate children, replace parents, apply the hybrid and record the best*/
+void ga_run_step(GA_Run *run)
+{
+	Population *parents = run->parents;
+	Population *children = run->children;
+	Generation *gen = &run->gen;
+	PROFILE_MARK(mark);
+
+	if (run->config.use_scaling) {
+		scaling(parents);
+		PROFILE_LAP(&run->profile, PHASE_SCALING, mark);
+	}
+
+	/*
+	** crossover, mutation, keep parents' elite and calculate fitness, chunk by chunk
+	*/
+	gen->graph = run->graph;
+	gen->parents = parents;
+	gen->children = children;
+	gen->roulette = NULL;
+	gen->use_cache = run->config.eval_cache;
+	if (gen->use_cache) {
+		population_index(parents);
+	}
+	if (run->config.select_method == 1) {
+		alias_table_build(&run->roulette, parents->fitness, parents->size);
+		gen->roulette = &run->roulette;
+		PROFILE_LAP(&run->profile, PHASE_SELECTION, mark);
+	}
+	gen->elite = run->config.use_elite ? (int)run->parent_best : -1;
+	breed_generation(gen, run->tasks, run->rng, run->pool);
+	for (int c = 0; c < gen->chunk_number; c++) {
+		run->eval_times += run->tasks[c].evaluated;
+		run->avoided_times += run->tasks[c].avoided;
+	}
+#if GA_PROFILE
+	for (int c = 0; c < gen->chunk_number; c++) {
+		profile_merge(&run->profile, &run->tasks[c].profile);
+		profile_clear(&run->tasks[c].profile);
+	}
+	mark = profile_now();	/*the chunks timed themselves*/
+#endif
+
+	/*
+	** update parents: the children become the parents, the old parents' storage takes the next children.
+	*/
+	run->parents = children;
+	run->children = parents;
+	parents = run->parents;
+	run->parent_best = select_elite(parents);
+	PROFILE_LAP(&run->profile, PHASE_ELITE, mark);
+
+	/*
+	** use hybrid
+	*/
+	if (parents->fitness[run->parent_best] != 1.0 && run->config.use_hybrid) {
+		Chromosome *best = parents->chromos + run->parent_best;
+		int moves = 0;
+
+		switch (run->config.hybrid)
+		{
+		case 1:
+			moves = assessment_strategy(run->graph, best);
+			break;
+		case 2:
+			moves = hill_climbing(run->graph, best, run->rng);
+			break;
+		case 3:
+			moves = tabu_col(run->graph, best, &run->tabu, &run->config, run->rng);
+			break;
+		default:
+			break;
+		}
+		run->eval_times += moves;
+		parents->fitness[run->parent_best] = conflict_state_fitness(&best->state);
+		if (run->config.eval_cache) {
+			parents->hashes[run->parent_best] = gene_hash(best->solution, parents->node_number);
+		}
+		PROFILE_COUNT(&run->profile, evaluations, moves);
+		PROFILE_COUNT(&run->profile, ls_moves, moves);
+		PROFILE_LAP(&run->profile, PHASE_LOCAL_SEARCH, mark);
+	}
+
+	run->gbest = parents->fitness[run->parent_best];
+	run->count += 1;
+	trace_add(&run->trace, run->count, run->eval_times, run->gbest);
+	PROFILE_COUNT(&run->profile, generations, 1);
+
+	if (PRINT_DETAIL) {
+		printf("\tLoop %4d ==========> %.5f\n", run->count, run->gbest);
+	}
+}
+
+/*release the memory held by a run*/
+void ga_run_free(GA_Run *run)
+{
+	population_free(run->pops);
+	population_free(run->pops + 1);
+	free(run->gen.streams);
+	free(run->tasks);
+	trace_free(&run->trace);
+	tabu_free(&run->tabu);
+	alias_table_free(&run->roulette);
+	memset(run, 0, sizeof *run);
+}
+
+/*
+** solve graph with run, whose buffers are kept for the next graph (see ga_run_restart). the arguments are those of genetic_algorithm,
+** and so is the result. the run stays initialized afterwards, ga_run_free releases it.
+*/
+Result *ga_run_solve(GA_Run *run, Graph const *graph, int pop_size, GA_Config const *config, Rng *rng, Thread_Pool *pool)
+{
+	int node_number = graph->node_number;
+	Result *result_record = NULL;
 	int success = 0;
 
-	char *s_start_time = NULL;
-	char *s_end_time = NULL;
 	time_t start_time;
 	time_t end_time;
-	double used_time = 0.0;
-	char s_used_time[50] = { 0 };
 	char s_elapsed_times[100] = "";
 
 	/*
 	** get start time.
 	*/
 	start_time = time(NULL);
-	s_start_time = ctime(&start_time);
+	PROFILE_MARK(mark);
 
-	/*
-	** initialize firefly list, then set old fire fly list.
-	*/
-	initialize(parents, graph);
-	memset(children, 0, sizeof children);
-	parent_best = select_elite(parents);
-	gbest = parents[parent_best].fitnessValue;
-	gbest_list[0] = gbest;
+	ga_run_restart(run, graph, pop_size, config, rng, pool);
 
-	while (count < MAX_LOOP) {
+	while (run->count < run->config.max_loop) {
 		/*
 		** if the best solution is found.
 		*/
-		if (gbest == 1.0) {
+		if (run->gbest == 1.0) {
 			success = 1;
 
 			if (PRINT_DETAIL) {
@@ -433,94 +1063,59 @@ Result *genetic_algorithm(char const (*graph)[NODE_NUMBER])
 			break;
 		}
 
-		if (USE_SCALING) {
-			scaling(parents);
-		}
-
-		/*
-		** crossover and mutation
-		*/
-		crossover(parents, children);
-		mutation(children, MUTATE_RATE);
-
-		/*
-		** keep parents' elite
-		*/
-		if (USE_ELITE) {
-			children[parent_best] = parents[parent_best];
-		}
-
-		/*
-		** calculate fitness
-		*/
-		for (int i = 0; i < POP_SIZE; i++) {
-			children[i].fitnessValue = fitness(graph, children[i].solution);
-			eval_times += 1;
-		}
-
-		/*
-		** update parents
-		*/
-		memcpy(parents, children, sizeof children);
-		parent_best = select_elite(parents);
-		memset(children, 0, sizeof children);
-
-		/*
-		** use hybrid
-		*/
-		if (parents[parent_best].fitnessValue != 1.0 && USE_HYBRID) {
-			switch (HYBRID)
-			{
-			case 1:
-				eval_times += assessment_strategy(graph, parents + parent_best);
-				break;
-			case 2:
-				eval_times += hill_climbing(graph, parents + parent_best);
-				break;
-			default:
-				break;
-			}
-		}
-
-		memcpy(current_best_solution, parents[parent_best].solution, sizeof parents->solution);
-		gbest = parents[parent_best].fitnessValue;
-		gbest_list[count] = gbest;
-
-		if (PRINT_DETAIL) {
-			printf("\tLoop %4d ==========> %.5f\n", count + 1, gbest);
-		}
-
-		count += 1;
+		ga_run_step(run);
 	} /*end of while*/
 
 	/*
 	** calculate elapsed times.
 	*/
 	end_time = time(NULL);
-	s_end_time = ctime(&end_time);
 	elapsed_times(&start_time, &end_time, s_elapsed_times);
+#if GA_PROFILE
+	run->profile.total_ns = profile_now() - mark;
+#endif
 
 	/*
-	** save result to record.
+	** save result to record, it is sized for the trace of the run.
 	*/
+	result_record = result_create(node_number, run->trace.len);
+	result_record->start_seconds = (long long)start_time;
+	result_record->end_seconds = (long long)end_time;
+	time_to_string(&start_time, result_record->start_time, sizeof result_record->start_time);
+	time_to_string(&end_time, result_record->end_time, sizeof result_record->end_time);
+	memcpy(result_record->trace, run->trace.points, run->trace.len * sizeof(Trace_Point));
+	memcpy(result_record->solution, run->parents->chromos[run->parent_best].solution, node_number);
 	result_record->success = success;
-	result_record->eval_times = eval_times;
-	result_record->loop_times = count;
-	memcpy(result_record->solution, current_best_solution, sizeof current_best_solution);
-	memcpy(result_record->gbest_list, gbest_list, sizeof gbest_list);
-	strcpy(result_record->start_time, s_start_time);
-	strcpy(result_record->end_time, s_end_time);
+	result_record->eval_times = run->eval_times;
+	result_record->avoided_times = run->avoided_times;
+	result_record->loop_times = run->count;
 	strcpy(result_record->s_elapsed_times, s_elapsed_times);
+	result_record->profile = run->profile;
 
 	return result_record;
+}
+
+/*
+** genetic algorithm, pop_size chromosomes are evolved with the operators of config, NULL means the defaults.
+** all random numbers of the run are drawn from rng. breeding and evaluation of each generation are spread over pool,
+** NULL means the calling thread does all of it. the result does not depend on the pool or its size.
+*/
+Result *genetic_algorithm(Graph const *graph, int pop_size, GA_Config const *config, Rng *rng, Thread_Pool *pool)
+{
+	GA_Run run;
+	Result *result_record = NULL;
+
+	memset(&run, 0, sizeof run);
+	result_record = ga_run_solve(&run, graph, pop_size, config, rng, pool);
+	ga_run_free(&run);
 
-	return NULL;
+	return result_record;
 }
 
 /*save result to two files*/
 int save_result(Result const *result, char const *file_name)
 {
-	FILE *file_csv = NULL;	/*save global best fitness value list*/
+	FILE *file_csv = NULL;	/*save convergence trace*/
 	FILE *file_txt = NULL;	/*save other information*/
 
 	char const *csv = ".csv";
@@ -546,10 +1141,10 @@ int save_result(Result const *result, char const *file_name)
 	}
 
 	/*
-	**save global best list to csv file
+	**save convergence trace to csv file, one line per change of the global best
 	*/
-	for (int i = 0; i < result->loop_times; i++) {
-		fprintf(file_csv, "%8d, %.8f\n", i + 1, result->gbest_list[i]);
+	for (int i = 0; i < result->trace_len; i++) {
+		fprintf(file_csv, "%8d, %.6e, %.8f\n", result->trace[i].generation, result->trace[i].eval_times, result->trace[i].fitness);
 	}
 
 	/*
@@ -559,13 +1154,18 @@ int save_result(Result const *result, char const *file_name)
 	fprintf(file_txt, "Find optimal value or not: \t %d\n", result->success);
 	fprintf(file_txt, "Loop times: \t %d\n", result->loop_times);
 	fprintf(file_txt, "Evaluation times: \t %.9e\n", result->eval_times);
+	fprintf(file_txt, "Avoided evaluations: \t %.9e\n", result->avoided_times);
 	fprintf(file_txt, "Used times: \t %s\n", result->s_elapsed_times);
 	fprintf(file_txt, "The best solution is: \t \n");
-	for (int i = 0; i < NODE_NUMBER; i++) {
+	for (int i = 0; i < result->node_number; i++) {
 		fprintf(file_txt, "%3d, ", result->solution[i]);
 	}
 	fprintf(file_txt, "\n\n");
 	fprintf(file_txt, "End time: \t %s\n", result->end_time);
+	if (GA_PROFILE) {
+		fprintf(file_txt, "\n");
+		profile_print(file_txt, &result->profile, "the run");
+	}
 
 	fclose(file_csv);
 	fclose(file_txt);
@@ -6,82 +6,263 @@
 #include <string.h>
 #include <time.h>
 
-#include "mt.h"
+#include "rng.h"
 #include "problem.h"
+#include "kernels.h"
+#include "bitslice.h"
+#include "threadpool.h"
+#include "trace.h"
+#include "profile.h"
+#include "config.h"
+#include "tabu.h"
 
-#define POP_SIZE	200
-#define MAX_LOOP	10000
+#define DEFAULT_POP_SIZE	200	/*population size used when none is given*/
 #define MAX_HILLCLIMB	45
-#define MUTATE_RATE	0.014
-#define USE_ELITE	1
-#define USE_SCALING	1
-#define CROSS_METHOD	2	/*crossover method.	1--point crossover.	2--mask crossover*/
-#define SELECT_METHOD	2	/*select method. 1--roulette select. 2--tournament select*/
-#define K_CANDIDATE	2	/*number of candidate chromosome in tournament select*/
-#define USE_HYBRID	0
-#define HYBRID		2
 #define PRINT_DETAIL	0
+#define REBASE_RATE	0.5	/*a child which differs from its origin parent in more than this rate of genes is evaluated from scratch*/
+#define CHUNK_PAIRS	8	/*pairs of children bred by one task. each chunk has its own stream, so the chunks, not the threads, fix the random numbers*/
 
-/*chromosome structure*/
+/*chromosome structure, its fitness is kept in the fitness array of its population*/
 typedef struct Chromosome {
-	char solution[NODE_NUMBER];	/*candidate solution*/
-	double fitnessValue;	/*fitness of candidate solution*/
+	char *solution;	/*candidate solution, it points into the gene buffer of its population*/
+	int origin;	/*index of the parent which this chromosome inherits most genes from, -1 means no parent*/
+	Conflict_State state;	/*conflict state of candidate solution*/
 } Chromosome;
 
+/*
+** population of chromosomes, genes, fitness and conflict states of all chromosomes are kept in heap buffers.
+** a run owns two populations and swaps them by pointer each generation, nothing is copied or cleared.
+*/
+typedef struct Population {
+	int size;	/*number of chromosomes*/
+	int node_number;	/*number of genes of each chromosome*/
+	Chromosome *chromos;	/*chromosome list*/
+	double *fitness;	/*fitness of each chromosome, selection and statistics scan this dense array*/
+	char *genes;	/*genes of all chromosomes, chromosome i owns genes[i * node_number] ... */
+	int *node_conflicts;	/*node conflicts of all conflict states, laid out like genes*/
+	uint64_t *masks;	/*crossover masks, one row of BIT_WORDS(node_number) words per pair of chromosomes (see Cross_Kernels)*/
+	char *dirty;	/*1 if the genes of a child were changed by crossover or mutation, 0 if they are those of its origin parent*/
+	uint64_t *hashes;	/*gene_hash of each chromosome, it is only kept up to date if the evaluation cache is used*/
+	int *twins;	/*hash table of the chromosomes by their hashes, -1 is an empty slot (see population_index)*/
+	int twin_mask;	/*number of slots of twins - 1, it is a power of 2 at least twice size*/
+	Cross_Kernels const *cross;	/*mask crossover kernels of the instruction set of this cpu*/
+	Slice_Kernels const *slice;	/*bitsliced kernels which evaluate the whole population at once*/
+	int *conflicts;	/*conflict links of each chromosome while the population is initialized*/
+	uint64_t *planes;	/*bit planes of the bitsliced kernels while the population is initialized*/
+	int capacity;	/*number of chromosomes the buffers can hold*/
+	size_t gene_capacity;	/*number of genes the gene and node conflict buffers can hold*/
+	size_t mask_capacity;	/*number of words the mask buffer can hold*/
+	size_t plane_capacity;	/*number of words planes can hold*/
+} Population;
+
+/*alias table of roulette selection (Vose). it is built from the fitness of a population once per generation, then a pick costs O(1)*/
+typedef struct Alias_Table {
+	int size;	/*number of chromosomes*/
+	int capacity;	/*number of chromosomes the table can hold*/
+	double *prob;	/*slot i picks chromosome i with probability prob[i], else alias[i]*/
+	int *alias;
+	int *work;	/*slots below and above the mean weight while the table is built*/
+} Alias_Table;
+
+struct Generation;
+
+struct Breed_Task;
+
+/*breed the pairs of one chunk of a generation, its phase times and evaluations are added to task. there is one per operator set*/
+typedef void(*Breed_Func)(struct Generation const *gen, struct Breed_Task *task);
+
+/*work of one generation, it is shared by all chunks*/
+typedef struct Generation {
+	GA_Config const *config;
+	Breed_Func breed;	/*pipeline of the operators of config, it is chosen once when the run starts*/
+	Graph const *graph;
+	Population const *parents;
+	Population *children;
+	Alias_Table const *roulette;	/*roulette over the fitness of parents, NULL unless roulette selection is used*/
+	int use_cache;	/*look the dirty children up in the hash table of parents*/
+	int elite;	/*index of the parent which is kept, -1 means no elite*/
+	int chunk_number;	/*number of chunks of CHUNK_PAIRS pairs*/
+	Rng *streams;	/*one stream per chunk*/
+} Generation;
+
+/*one chunk of a generation, it is the argument of breed_task*/
+typedef struct Breed_Task {
+	Generation const *gen;
+	int chunk;
+	Profile profile;	/*phases of this chunk, they are added to the run after each generation*/
+	int evaluated;	/*children of this chunk which were evaluated*/
+	int avoided;	/*children of this chunk which took the conflict state of an equal parent instead*/
+} Breed_Task;
+
+/*a running genetic algorithm. genetic_algorithm() and the islands step it one generation at a time*/
+typedef struct GA_Run {
+	GA_Config config;	/*operators and parameters of the run*/
+	Graph const *graph;
+	Population pops[2];	/*storage of both populations*/
+	Population *parents;	/*points to one of pops*/
+	Population *children;	/*points to the other one, children are bred straight into it*/
+	Rng *rng;	/*stream of the run*/
+	Thread_Pool *pool;	/*pool for the chunks of a generation, NULL means the calling thread*/
+	Generation gen;	/*chunks of a generation*/
+	Breed_Task *tasks;	/*one task per chunk*/
+	int chunk_capacity;	/*number of chunks tasks and the streams of gen can hold*/
+	unsigned int parent_best;	/*the index of current best chromosome*/
+	double gbest;	/*the global best fitness*/
+	double eval_times;	/*evaluation times of object function*/
+	double avoided_times;	/*evaluations skipped because a child was equal to a parent*/
+	int count;	/*number of generations*/
+	Trace trace;	/*change points of the global best fitness*/
+	Profile profile;	/*phase times and counters, see profile.h*/
+	Tabu_Search tabu;	/*workspace of the tabu search, it is only allocated for hybrid 3*/
+	Alias_Table roulette;	/*roulette of the parents, it is only allocated for roulette selection*/
+} GA_Run;
+
 /*record the result*/
 typedef struct Result {
 	int success;
 	int loop_times;
 	double eval_times;
-	double gbest_list[MAX_LOOP];
-	char solution[NODE_NUMBER];
+	double avoided_times;	/*evaluations skipped because a child was equal to a parent*/
+	int trace_len;	/*number of change points of the convergence trace*/
+	Trace_Point *trace;	/*convergence trace, it is stored right after the record*/
+	int node_number;
+	char *solution;	/*best solution, its node_number genes are stored right after the trace*/
+	long long start_seconds;	/*start time in seconds since the epoch*/
+	long long end_seconds;	/*end time in seconds since the epoch*/
 	char start_time[50];
 	char end_time[50];
 	char s_elapsed_times[100];
+	Profile profile;	/*phase times and counters of the run, all 0 unless GA_PROFILE is 1*/
 } Result;
 
-/*this function is used by qsort function*/
+/*this function is used by qsort function, it sorts fitness values from the best*/
 int f_compare(void const *a, void const *b);
 
-/*initialize chromosome list*/
-void initialize(Chromosome *chromo_list, char const(*graph)[NODE_NUMBER]);
+/*allocate a population of size chromosomes with node_number genes each*/
+void population_init(Population *pop, int size, int node_number);
+
+/*
+** make pop a population of size chromosomes with node_number genes each. its buffers are only grown when they are too small,
+** so a population can be reused for graphs of any size. the chromosomes are not initialized. a population set to { 0 } can be passed.
+*/
+void population_reserve(Population *pop, int size, int node_number);
+
+/*release the memory held by population*/
+void population_free(Population *pop);
+
+/*copy chromosome src_index of population src to chromosome dst_index of population dst*/
+void copy_chromosome(Population *dst, int dst_index, Population const *src, int src_index);
+
+/*initialize chromosome list, the random solutions are evaluated together by the bitsliced kernels*/
+void initialize(Population *pop, Graph const *graph, Rng *rng);
+
+/*build the hash table of the chromosomes of pop from their hashes*/
+void population_index(Population *pop);
+
+/*index of a chromosome of pop whose genes are solution, hash is the gene_hash of solution. return -1 if there is none*/
+int population_find(Population const *pop, char const *solution, uint64_t hash);
 
 /*calculate total fitness of population*/
-double total_fitness(Chromosome const *chromo_list);
+double total_fitness(Population const *pop);
+
+/*allocate an alias table for populations of size chromosomes*/
+void alias_table_init(Alias_Table *table, int size);
+
+/*release the memory held by an alias table*/
+void alias_table_free(Alias_Table *table);
+
+/*
+** build the roulette of size weights in O(size), chromosome i is picked with probability weights[i] / total.
+** if fewer than two weights are positive, the picks are uniform, so two different chromosomes can always be selected.
+*/
+void alias_table_build(Alias_Table *table, double const *weights, int size);
 
-/*select a chromosome with roulette*/
-unsigned int roulette_selection(Chromosome const *chromo_list, double sum_fitness);
+/*select a chromosome with roulette, table is built from the fitness of the population*/
+unsigned int roulette_selection(Alias_Table const *table, Rng *rng);
 
-/*select a chromosome with tournament*/
-unsigned int tournament_selection(Chromosome const *chromo_list);
+/*select a chromosome with tournament of k_candidate different chromosomes*/
+unsigned int tournament_selection(Population const *pop, int k_candidate, Rng *rng);
 
 /*
-**crossover chromosomes and generate children population. you should choose a crossover method by macro.
+**crossover chromosomes and generate the children pairs first_pair ... last_pair - 1. the crossover and select methods are taken from config.
 **	1--point crossover
 **	2--mask crossover
+** mask crossover uses the first mask of children population, or draws a mask per pair into its row if config->mask_per_pair is set. roulette is the alias table of parents (only read by roulette selection).
+** selection and crossover times are added to profile, it may be NULL.
 */
-void crossover(Chromosome const *parent_chromo_list, Chromosome *children_chromo_list);
+void crossover(GA_Config const *config, Population const *parents, Population *children, int first_pair, int last_pair,
+	Alias_Table const *roulette, Rng *rng, Profile *profile);
+
+/*mutate chromosomes first ... last - 1 to a new type, the mutated chromosomes are marked dirty*/
+void mutation(Population *pop, int first, int last, double m_rate, Rng *rng);
+
+/*evaluate a child chromosome and return its fitness. if it is close to its origin parent, the parent's conflict state is updated to it incrementally*/
+double evaluate_chromosome(Graph const *graph, Population const *parents, Chromosome *chromo);
 
-/*mutate chromosome to a new type*/
-void mutation(Chromosome *chromo, double m_rate);
+/*
+** set the conflict state and the fitness of child index of children. a clean child takes the state of its origin parent,
+** with use_cache a dirty child which is equal to a parent takes the state of that parent, only the others are evaluated.
+** return 1 if the child was evaluated, 0 if the evaluation was avoided.
+*/
+int assess_child(Graph const *graph, Population const *parents, Population *children, int index, int use_cache);
 
 /*select the best solution in the current population*/
-unsigned select_elite(Chromosome const *chromo_list);
+unsigned select_elite(Population const *pop);
 
 /*scaling fitness*/
-void scaling(Chromosome *chromo_list);
+void scaling(Population *pop);
+
+/*
+** local search algorithms. they keep the conflict state of the chromosome up to date,
+** so its fitness is conflict_state_fitness(&chromo->state) afterwards.
+*/
 
 /*assessment strategy is a local search algorithm. hybrid number: 1*/
-int assessment_strategy(char const (*graph)[NODE_NUMBER], Chromosome *chromo);
+int assessment_strategy(Graph const *graph, Chromosome *chromo);
 
 /*hill climbing is a local search algorithm. hybrid number: 2*/
-int hill_climbing(char const (*graph)[NODE_NUMBER], Chromosome *current_chromo);
+int hill_climbing(Graph const *graph, Chromosome *current_chromo, Rng *rng);
+
+/*tabu search (TabuCol) is a local search algorithm, the tabu parameters are taken from config. hybrid number: 3*/
+int tabu_col(Graph const *graph, Chromosome *chromo, Tabu_Search *tabu, GA_Config const *config, Rng *rng);
 
 /*calculate elapsed times, convert it to string*/
 void elapsed_times(time_t const *start_time, time_t const *end_time, char *used_time);
 
-/*genetic algorithm*/
-Result *genetic_algorithm(char const (*graph)[NODE_NUMBER]);
+/*convert time to a string in the format of ctime. unlike ctime, it writes to buffer, so several threads can call it*/
+void time_to_string(time_t const *t, char *buffer, size_t size);
+
+/*allocate a result record with room for trace_len change points and a solution of node_number genes, one free() releases all*/
+Result *result_create(int node_number, int trace_len);
+
+/*initialize a run: allocate its populations, generate the first parents and select the best one. config NULL means the defaults*/
+void ga_run_init(GA_Run *run, Graph const *graph, int pop_size, GA_Config const *config, Rng *rng, Thread_Pool *pool);
+
+/*
+** initialize a run again, maybe on another graph with another population size and config. the buffers of the run are kept
+** and only grown when they are too small, so a service solving many graphs allocates almost nothing per graph.
+** a run released by ga_run_free can be passed. the run is the same as one of ga_run_init.
+*/
+void ga_run_restart(GA_Run *run, Graph const *graph, int pop_size, GA_Config const *config, Rng *rng, Thread_Pool *pool);
+
+/*evolve a run by one generation: breed and evaluate children, replace parents, apply the hybrid and record the best*/
+void ga_run_step(GA_Run *run);
+
+/*release the memory held by a run*/
+void ga_run_free(GA_Run *run);
+
+/*
+** solve graph with run, whose buffers are kept for the next graph (see ga_run_restart). the arguments are those of genetic_algorithm,
+** and so is the result. the run stays initialized afterwards, ga_run_free releases it.
+*/
+Result *ga_run_solve(GA_Run *run, Graph const *graph, int pop_size, GA_Config const *config, Rng *rng, Thread_Pool *pool);
+
+/*
+** genetic algorithm, pop_size chromosomes are evolved with the operators of config, NULL means the defaults.
+** all random numbers of the run are drawn from rng. breeding and evaluation of each generation are spread over pool,
+** NULL means the calling thread does all of it. the result does not depend on the pool or its size.
+*/
+Result *genetic_algorithm(Graph const *graph, int pop_size, GA_Config const *config, Rng *rng, Thread_Pool *pool);
 
 /*save result to two files*/
 int save_result(Result const *result, char const *file_name);
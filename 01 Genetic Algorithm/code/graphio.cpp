@@ -0,0 +1,394 @@
+#include "graphio.h"
+#include "bitpack.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define READ_BUFFER_SIZE	(1 << 16)	/*bytes read at a time by the DIMACS reader*/
+
+/*header of a binary graph file*/
+typedef struct Graph_Header {
+	char magic[4];
+	int32_t version;
+	int32_t node_number;
+	int32_t edge_number;
+	int32_t flags;
+	int32_t reserved[3];
+} Graph_Header;
+
+/*a mapped graph file*/
+struct graph_mapping {
+	void const *data;
+	size_t size;
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE map;
+#endif
+};
+
+/*save graph to a binary graph file. coloring is a planted coloring of node number genes, it may be NULL*/
+int graph_save_binary(Graph const *graph, char const *path, char const *coloring)
+{
+	Graph_Header header;
+	FILE *file = NULL;
+	size_t offset_number = (size_t)graph->node_number + 1;
+	size_t link_number = 2 * (size_t)graph->edge_number;
+
+	memset(&header, 0, sizeof header);
+	memcpy(header.magic, GRAPH_MAGIC, 4);
+	header.version = GRAPH_VERSION;
+	header.node_number = graph->node_number;
+	header.edge_number = graph->edge_number;
+	header.flags = coloring != NULL ? GRAPH_HAS_COLORING : 0;
+
+	if ((file = fopen(path, "wb")) == NULL) {
+		printf("[GRAPHIO.cpp--graph_save_binary--ERROR] cannot open %s\n", path);
+		exit(EXIT_FAILURE);
+	}
+	if (fwrite(&header, sizeof header, 1, file) != 1 ||
+		fwrite(graph->offsets, sizeof(int32_t), offset_number, file) != offset_number ||
+		fwrite(graph->neighbours, sizeof(int32_t), link_number, file) != link_number ||
+		(coloring != NULL && fwrite(coloring, 1, graph->node_number, file) != (size_t)graph->node_number)) {
+		printf("[GRAPHIO.cpp--graph_save_binary--ERROR] cannot write %s\n", path);
+		exit(EXIT_FAILURE);
+	}
+	fclose(file);
+
+	return EXIT_SUCCESS;
+}
+
+/*map the whole file at path read only*/
+static struct graph_mapping *map_file(char const *path)
+{
+	struct graph_mapping *mapping = (struct graph_mapping *)calloc(1, sizeof(struct graph_mapping));
+
+	if (mapping == NULL) {
+		printf("[GRAPHIO.cpp--map_file--ERROR] cannot allocate memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+#ifdef _WIN32
+	LARGE_INTEGER size;
+
+	mapping->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (mapping->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(mapping->file, &size) || size.QuadPart == 0 ||
+		(mapping->map = CreateFileMappingA(mapping->file, NULL, PAGE_READONLY, 0, 0, NULL)) == NULL ||
+		(mapping->data = MapViewOfFile(mapping->map, FILE_MAP_READ, 0, 0, 0)) == NULL) {
+		printf("[GRAPHIO.cpp--map_file--ERROR] cannot map %s\n", path);
+		exit(EXIT_FAILURE);
+	}
+	mapping->size = (size_t)size.QuadPart;
+#else
+	struct stat status;
+	int fd = open(path, O_RDONLY);
+	void *data = NULL;
+
+	if (fd < 0 || fstat(fd, &status) != 0 || status.st_size == 0 ||
+		(data = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+		printf("[GRAPHIO.cpp--map_file--ERROR] cannot map %s\n", path);
+		exit(EXIT_FAILURE);
+	}
+	close(fd);	/*the mapping stays valid*/
+	mapping->data = data;
+	mapping->size = (size_t)status.st_size;
+#endif
+
+	return mapping;
+}
+
+/*release the file mapping of graph, its adjacency lists are empty afterwards. nothing is done if it is not mapped*/
+void graph_unmap(Graph *graph)
+{
+	struct graph_mapping *mapping = graph->mapping;
+
+	if (mapping == NULL) {
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(mapping->data);
+	CloseHandle(mapping->map);
+	CloseHandle(mapping->file);
+#else
+	munmap((void *)mapping->data, mapping->size);
+#endif
+	free(mapping);
+
+	graph->mapping = NULL;
+	graph->offsets = NULL;
+	graph->neighbours = NULL;
+	graph->node_capacity = 0;
+	graph->edge_capacity = 0;
+	graph->node_number = 0;
+	graph->edge_number = 0;
+}
+
+/*
+** check the adjacency lists of a mapped graph in one pass: offsets never decrease, and every neighbour is a node
+** other than the node itself. return 0 if they are broken
+*/
+static int check_adjacency(Graph const *graph)
+{
+	int node_number = graph->node_number;
+
+	if (graph->offsets[0] != 0 || graph->offsets[node_number] != 2 * graph->edge_number) {
+		return 0;
+	}
+	for (int i = 0; i < node_number; i++) {
+		if (graph->offsets[i] > graph->offsets[i + 1]) {
+			return 0;
+		}
+		for (int j = graph->offsets[i]; j < graph->offsets[i + 1]; j++) {
+			int neighbour = graph->neighbours[j];
+
+			if (neighbour < 0 || neighbour >= node_number || neighbour == i) {
+				return 0;
+			}
+		}
+	}
+	return 1;
+}
+
+/*
+** map a binary graph file into graph without parsing it, the adjacency lists point into the mapping
+** until graph_free() or graph_reserve() releases it. the file is checked against its header, and its adjacency
+** lists are checked before they are used. a graph needs 2 nodes and 1 link, and no link may be repeated.
+** *coloring is set to the planted coloring in the mapping, or NULL if the file has none. coloring may be NULL.
+*/
+int graph_map_binary(Graph *graph, char const *path, char const **coloring)
+{
+	struct graph_mapping *mapping = map_file(path);
+	Graph_Header const *header = (Graph_Header const *)mapping->data;
+	size_t size = sizeof(Graph_Header);
+	int *marks = NULL;	/*workspace of check_repeated_links*/
+
+	if (mapping->size >= sizeof(Graph_Header)) {
+		size += ((size_t)header->node_number + 1 + 2 * (size_t)header->edge_number) * sizeof(int32_t);
+		size += header->flags & GRAPH_HAS_COLORING ? (size_t)header->node_number : 0;
+	}
+	if (mapping->size < sizeof(Graph_Header) || memcmp(header->magic, GRAPH_MAGIC, 4) != 0 || header->version != GRAPH_VERSION ||
+		header->node_number < 0 || header->edge_number < 0 || header->edge_number > INT32_MAX / 2 || mapping->size != size) {
+		printf("[GRAPHIO.cpp--graph_map_binary--ERROR] %s is not a binary graph file\n", path);
+		exit(EXIT_FAILURE);
+	}
+
+	/*
+	** whatever graph held before is released, then its adjacency lists point into the mapping.
+	*/
+	graph_free(graph);
+	graph->mapping = mapping;
+	graph->node_number = header->node_number;
+	graph->edge_number = header->edge_number;
+	graph->offsets = (int *)(header + 1);
+	graph->neighbours = graph->offsets + header->node_number + 1;
+	if (graph->node_number < 2 || graph->edge_number < 1) {
+		printf("[GRAPHIO.cpp--graph_map_binary--ERROR] %s has fewer than 2 nodes or no link\n", path);
+		exit(EXIT_FAILURE);
+	}
+	if (!check_adjacency(graph)) {
+		printf("[GRAPHIO.cpp--graph_map_binary--ERROR] %s has broken adjacency lists\n", path);
+		exit(EXIT_FAILURE);
+	}
+	if ((marks = (int *)malloc(graph->node_number * sizeof(int))) == NULL) {
+		printf("[GRAPHIO.cpp--graph_map_binary--ERROR] cannot allocate memory\n");
+		exit(EXIT_FAILURE);
+	}
+	if (check_repeated_links(graph, marks) != NULL) {
+		printf("[GRAPHIO.cpp--graph_map_binary--ERROR] %s has a repeated link\n", path);
+		exit(EXIT_FAILURE);
+	}
+	free(marks);
+	if (coloring != NULL) {
+		*coloring = header->flags & GRAPH_HAS_COLORING ? (char const *)(graph->neighbours + 2 * (size_t)graph->edge_number) : NULL;
+	}
+
+	if (graph_bits_worthwhile(graph)) {
+		graph_build_bits(graph);
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/*buffered reader of a text file*/
+typedef struct Text_Reader {
+	FILE *file;
+	char *buffer;
+	size_t pos;
+	size_t len;
+} Text_Reader;
+
+/*next character of the file, EOF at the end*/
+static inline int next_char(Text_Reader *reader)
+{
+	if (reader->pos == reader->len) {
+		reader->len = fread(reader->buffer, 1, READ_BUFFER_SIZE, reader->file);
+		reader->pos = 0;
+		if (reader->len == 0) {
+			return EOF;
+		}
+	}
+	return (unsigned char)reader->buffer[reader->pos++];
+}
+
+/*skip the rest of the line, return the first character of the next one*/
+static int skip_line(Text_Reader *reader, int c)
+{
+	while (c != '\n' && c != EOF) {
+		c = next_char(reader);
+	}
+	return c == EOF ? EOF : next_char(reader);
+}
+
+/*read an unsigned integer which starts at *c, -1 if there is none on this line. *c is the character after it*/
+static long read_number(Text_Reader *reader, int *c)
+{
+	long value = 0;
+
+	while (*c == ' ' || *c == '\t') {
+		*c = next_char(reader);
+	}
+	if (*c < '0' || *c > '9') {
+		return -1;
+	}
+	while (*c >= '0' && *c <= '9') {
+		if (value <= INT32_MAX) {
+			value = value * 10 + (*c - '0');	/*larger values are out of range anyway, they stay above INT32_MAX*/
+		}
+		*c = next_char(reader);
+	}
+	return value;
+}
+
+/*compare links packed as (smaller end << 32 | larger end), for qsort*/
+static int link_compare(void const *a, void const *b)
+{
+	uint64_t x = *(uint64_t const *)a;
+	uint64_t y = *(uint64_t const *)b;
+
+	return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/*
+** read a DIMACS .col graph ("p edge N E" and "e u v" lines, nodes from 1). self links and repeated links are dropped,
+** a graph needs 2 nodes and 1 link afterwards.
+*/
+int graph_read_dimacs(Graph *graph, char const *path)
+{
+	Text_Reader reader;
+	long node_number = -1;
+	size_t link_number = 0;
+	size_t link_capacity = 1024;
+	uint64_t *links = (uint64_t *)malloc(link_capacity * sizeof(uint64_t));
+	int *edges = NULL;
+	int count = 0;
+	int c = 0;
+
+	reader.buffer = (char *)malloc(READ_BUFFER_SIZE);
+	reader.pos = 0;
+	reader.len = 0;
+	if (links == NULL || reader.buffer == NULL) {
+		printf("[GRAPHIO.cpp--graph_read_dimacs--ERROR] cannot allocate memory\n");
+		exit(EXIT_FAILURE);
+	}
+	if ((reader.file = fopen(path, "rb")) == NULL) {
+		printf("[GRAPHIO.cpp--graph_read_dimacs--ERROR] cannot open %s\n", path);
+		exit(EXIT_FAILURE);
+	}
+
+	/*
+	** one line at a time: "c" comments, "p edge N E" the problem line, "e u v" a link. other lines are skipped.
+	*/
+	c = next_char(&reader);
+	while (c != EOF) {
+		if (c == 'p') {
+			c = next_char(&reader);
+			while (c == ' ' || c == '\t') {
+				c = next_char(&reader);
+			}
+			while (c != EOF && c != ' ' && c != '\t' && c != '\n') {
+				c = next_char(&reader);	/*format word, "edge" or "col"*/
+			}
+			node_number = read_number(&reader, &c);
+			if (node_number < 0 || node_number > INT32_MAX - 1) {
+				printf("[GRAPHIO.cpp--graph_read_dimacs--ERROR] %s has a broken problem line\n", path);
+				exit(EXIT_FAILURE);
+			}
+		}
+		else if (c == 'e') {
+			long u = 0;
+			long v = 0;
+
+			c = next_char(&reader);
+			u = read_number(&reader, &c);
+			v = read_number(&reader, &c);
+			if (node_number < 0 || u < 1 || v < 1 || u > node_number || v > node_number) {
+				printf("[GRAPHIO.cpp--graph_read_dimacs--ERROR] %s has a broken link line\n", path);
+				exit(EXIT_FAILURE);
+			}
+			if (u != v) {
+				if (link_number == link_capacity) {
+					link_capacity *= 2;
+					if ((links = (uint64_t *)realloc(links, link_capacity * sizeof(uint64_t))) == NULL) {
+						printf("[GRAPHIO.cpp--graph_read_dimacs--ERROR] cannot allocate memory\n");
+						exit(EXIT_FAILURE);
+					}
+				}
+				u -= 1;
+				v -= 1;
+				links[link_number++] = u < v ? (uint64_t)u << 32 | (uint64_t)v : (uint64_t)v << 32 | (uint64_t)u;
+			}
+		}
+		c = skip_line(&reader, c);
+	}
+	fclose(reader.file);
+	free(reader.buffer);
+
+	if (node_number < 0) {
+		printf("[GRAPHIO.cpp--graph_read_dimacs--ERROR] %s has no problem line\n", path);
+		exit(EXIT_FAILURE);
+	}
+
+	/*
+	** many files list a link in both directions, sorting puts repeats side by side.
+	*/
+	qsort(links, link_number, sizeof(uint64_t), link_compare);
+	if ((edges = (int *)malloc((2 * link_number + 1) * sizeof(int))) == NULL) {
+		printf("[GRAPHIO.cpp--graph_read_dimacs--ERROR] cannot allocate memory\n");
+		exit(EXIT_FAILURE);
+	}
+	for (size_t k = 0; k < link_number; k++) {
+		if (k == 0 || links[k] != links[k - 1]) {
+			edges[2 * count] = (int)(links[k] >> 32);
+			edges[2 * count + 1] = (int)(links[k] & 0xffffffffULL);
+			count += 1;
+		}
+	}
+
+	if (node_number < 2 || count < 1) {
+		printf("[GRAPHIO.cpp--graph_read_dimacs--ERROR] %s has fewer than 2 nodes or no link\n", path);
+		exit(EXIT_FAILURE);
+	}
+	graph_build(graph, (int)node_number, count, edges);
+
+	free(links);
+	free(edges);
+
+	return EXIT_SUCCESS;
+}
+
+/*read the graph file at path: a binary graph file if its name ends with ".graph" (it is mapped), else a DIMACS .col file*/
+int graph_load(Graph *graph, char const *path)
+{
+	size_t length = strlen(path);
+
+	if (length >= 6 && strcmp(path + length - 6, ".graph") == 0) {
+		return graph_map_binary(graph, path, NULL);
+	}
+	return graph_read_dimacs(graph, path);
+}
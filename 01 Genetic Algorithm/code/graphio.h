@@ -0,0 +1,47 @@
+#ifndef _HEADER_GRAPHIO_H
+#define _HEADER_GRAPHIO_H	1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "problem.h"
+
+#define GRAPH_MAGIC	"GAGR"	/*first 4 bytes of a binary graph file*/
+#define GRAPH_VERSION	1	/*version of the layout below*/
+#define GRAPH_HAS_COLORING	1	/*flag: a planted coloring follows the adjacency lists*/
+
+/*
+** binary graph file, native byte order, it is laid out so that a mapping of the file can be used as it is:
+**	char	GRAPH_MAGIC
+**	int32	GRAPH_VERSION, node number, edge number, flags, 3 reserved
+**	int32	offsets, node number + 1 of them (see Graph)
+**	int32	neighbours, 2 x edge number of them
+**	uint8	planted coloring, node number of them, only if flags has GRAPH_HAS_COLORING
+*/
+
+/*save graph to a binary graph file. coloring is a planted coloring of node number genes, it may be NULL*/
+int graph_save_binary(Graph const *graph, char const *path, char const *coloring);
+
+/*
+** map a binary graph file into graph without parsing it, the adjacency lists point into the mapping
+** until graph_free() or graph_reserve() releases it. the file is checked against its header, and its adjacency
+** lists are checked before they are used. a graph needs 2 nodes and 1 link, and no link may be repeated.
+** *coloring is set to the planted coloring in the mapping, or NULL if the file has none. coloring may be NULL.
+*/
+int graph_map_binary(Graph *graph, char const *path, char const **coloring);
+
+/*
+** read a DIMACS .col graph ("p edge N E" and "e u v" lines, nodes from 1). self links and repeated links are dropped,
+** a graph needs 2 nodes and 1 link afterwards.
+*/
+int graph_read_dimacs(Graph *graph, char const *path);
+
+/*read the graph file at path: a binary graph file if its name ends with ".graph" (it is mapped), else a DIMACS .col file*/
+int graph_load(Graph *graph, char const *path);
+
+/*release the file mapping of graph, its adjacency lists are empty afterwards. nothing is done if it is not mapped*/
+void graph_unmap(Graph *graph);
+
+#endif
@@ -0,0 +1,373 @@
+#include "island.h"
+#include "threadpool.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/*
+** a single-producer single-consumer mailbox. only the sending island moves tail and only the receiving island
+** moves head, so a slot is handed over by one release store and one acquire load, without any lock.
+*/
+typedef struct Mailbox {
+	std::atomic<unsigned> head;	/*next slot to read*/
+	std::atomic<unsigned> tail;	/*next slot to write*/
+	char *genes;	/*MAILBOX_SLOTS migrations of migrant_number solutions each, NULL if nobody sends here*/
+} Mailbox;
+
+/*shared state of an island run*/
+typedef struct Archipelago {
+	Graph const *graph;
+	Island_Config const *config;
+	GA_Config ga_config;	/*operators of every island*/
+	Mailbox *mailboxes;	/*island_number x island_number mailboxes, mailboxes[from * island_number + to]*/
+	std::atomic<int> solved;	/*set when any island finds a solution, every island stops then*/
+} Archipelago;
+
+/*one island*/
+typedef struct Island {
+	Archipelago *shared;
+	int index;
+	int pop_size;
+	Rng rng;	/*stream of the island, split from the run's stream*/
+	GA_Run run;
+	int *order;	/*scratch, chromosome indices sorted by fitness*/
+} Island;
+
+/*number of genes of one migration*/
+static size_t migration_size(Archipelago const *shared)
+{
+	return (size_t)shared->config->migrant_number * shared->graph->node_number;
+}
+
+/*the mailbox island from sends to island to*/
+static Mailbox *mailbox_of(Archipelago *shared, int from, int to)
+{
+	return shared->mailboxes + (size_t)from * shared->config->island_number + to;
+}
+
+/*population of the island whose fitness values are sorted from the best, used by qsort*/
+static thread_local Population const *sort_pop = NULL;
+
+/*order chromosome indices from the best fitness, used by qsort*/
+static int index_compare(void const *a, void const *b)
+{
+	double fa = sort_pop->fitness[*(int const *)a];
+	double fb = sort_pop->fitness[*(int const *)b];
+	return fa > fb ? -1 : (fa < fb ? 1 : 0);
+}
+
+/*sort the chromosome indices of the island's parents from the best*/
+static void sort_parents(Island *island)
+{
+	Population const *pop = island->run.parents;
+
+	for (int i = 0; i < pop->size; i++) {
+		island->order[i] = i;
+	}
+	sort_pop = pop;
+	qsort(island->order, pop->size, sizeof(int), index_compare);
+}
+
+/*send the best chromosomes of island to one neighbour. nothing is sent if its mailbox is full*/
+static void send_migrants(Island *island)
+{
+	Archipelago *shared = island->shared;
+	Island_Config const *config = shared->config;
+	int node_number = shared->graph->node_number;
+	int to = 0;
+
+	if (config->topology == TOPOLOGY_RANDOM) {
+		to = rng_below(&island->rng, config->island_number - 1);
+		to += to >= island->index;	/*skip the island itself*/
+	}
+	else {
+		to = (island->index + 1) % config->island_number;
+	}
+
+	Mailbox *mailbox = mailbox_of(shared, island->index, to);
+	unsigned tail = mailbox->tail.load(std::memory_order_relaxed);
+	if (tail - mailbox->head.load(std::memory_order_acquire) == MAILBOX_SLOTS) {
+		return;
+	}
+
+	char *slot = mailbox->genes + (tail % MAILBOX_SLOTS) * migration_size(shared);
+	for (int m = 0; m < config->migrant_number; m++) {
+		memcpy(slot + (size_t)m * node_number, island->run.parents->chromos[island->order[m]].solution, node_number);
+	}
+	mailbox->tail.store(tail + 1, std::memory_order_release);
+}
+
+/*take the migrations waiting for island, each migrant replaces one of the worst chromosomes*/
+static void receive_migrants(Island *island)
+{
+	Archipelago *shared = island->shared;
+	Island_Config const *config = shared->config;
+	GA_Run *run = &island->run;
+	int node_number = shared->graph->node_number;
+	int replaced = 0;
+
+	for (int from = 0; from < config->island_number; from++) {
+		Mailbox *mailbox = mailbox_of(shared, from, island->index);
+		if (mailbox->genes == NULL) {
+			continue;
+		}
+
+		unsigned head = mailbox->head.load(std::memory_order_relaxed);
+		while (head != mailbox->tail.load(std::memory_order_acquire)) {
+			char const *slot = mailbox->genes + (head % MAILBOX_SLOTS) * migration_size(shared);
+
+			for (int m = 0; m < config->migrant_number && replaced < run->parents->size - 1; m++) {
+				/*
+				** the worst chromosomes are at the end of order, the best one is never replaced.
+				*/
+				int index = island->order[run->parents->size - 1 - replaced];
+				Chromosome *chromo = run->parents->chromos + index;
+				memcpy(chromo->solution, slot + (size_t)m * node_number, node_number);
+				chromo->origin = -1;
+				conflict_state_init(shared->graph, chromo->solution, &chromo->state);
+				run->parents->fitness[index] = conflict_state_fitness(&chromo->state);
+				run->parents->hashes[index] = gene_hash(chromo->solution, node_number);
+				run->eval_times += 1;
+				replaced += 1;
+			}
+
+			head += 1;
+			mailbox->head.store(head, std::memory_order_release);
+		}
+	}
+
+	if (replaced > 0) {
+		run->parent_best = select_elite(run->parents);
+		run->gbest = run->parents->fitness[run->parent_best];
+	}
+}
+
+/*main loop of an island thread*/
+static void island_main(Island *island)
+{
+	Archipelago *shared = island->shared;
+	GA_Run *run = &island->run;
+
+	ga_run_init(run, shared->graph, island->pop_size, &shared->ga_config, &island->rng, NULL);
+
+	while (run->count < shared->ga_config.max_loop && !shared->solved.load(std::memory_order_relaxed)) {
+		if (run->gbest == 1.0) {
+			shared->solved.store(1, std::memory_order_relaxed);
+			break;
+		}
+
+		ga_run_step(run);
+
+		/*
+		** migrate every migration interval. the island's parents are sorted once for both directions.
+		*/
+		if (run->count % shared->config->migration_interval == 0) {
+			sort_parents(island);
+			send_migrants(island);
+			receive_migrants(island);
+			trace_add(&run->trace, run->count, run->eval_times, run->gbest);
+		}
+	}
+
+	if (run->gbest == 1.0) {
+		shared->solved.store(1, std::memory_order_relaxed);
+	}
+}
+
+/*an island as a task of a thread pool*/
+static void island_task(void *arg, int worker)
+{
+	(void)worker;
+	island_main((Island *)arg);
+}
+
+/*
+** island model genetic algorithm. the pop_size / 2 pairs of chromosomes are spread over the islands, which differ
+** by one pair at most. every island runs the genetic algorithm as a task of pool on a stream split from rng, and sends
+** its best chromosomes to a neighbour every migration interval. migrants go through lock-free mailboxes, so islands
+** never wait for each other and a pool with fewer workers than islands runs them in turns. pool is used by this run
+** alone, NULL means a thread of its own per island.
+** migrations arrive whenever their sender gets there, so unlike genetic_algorithm() a run is not repeatable.
+** every island runs with the operators of ga_config, NULL means the defaults.
+*/
+Result *island_algorithm(Graph const *graph, int pop_size, Island_Config const *config, GA_Config const *ga_config, Rng *rng, Thread_Pool *pool)
+{
+	int node_number = graph->node_number;
+	int island_number = config->island_number;
+	int pair_number = island_number > 0 ? pop_size / 2 / island_number : 0;	/*pairs of the smallest island, crossover breeds pairs*/
+	int extra_pairs = island_number > 0 ? pop_size / 2 % island_number : 0;	/*the first extra_pairs islands get one pair more*/
+	int island_size = 2 * pair_number;	/*size of the smallest island*/
+	Result *result_record = NULL;
+	Archipelago shared;
+	Island *islands = (Island *)calloc(island_number, sizeof(Island));
+	Trace trace;
+	int *positions = (int *)calloc(island_number, sizeof(int));
+	int *orders = (int *)malloc((size_t)(pop_size > 0 ? pop_size : 1) * sizeof(int));
+	int first = 0;	/*index of the first chromosome of an island in orders*/
+	std::vector<std::thread> threads;
+	int best_island = 0;
+
+	time_t start_time;
+	time_t end_time;
+
+	if (ga_config != NULL) {
+		shared.ga_config = *ga_config;
+	}
+	else {
+		ga_config_default(&shared.ga_config);
+	}
+	if (island_number < 2 || pop_size % 2 != 0 || island_size < shared.ga_config.k_candidate + 1 || config->migrant_number >= island_size) {
+		printf("[ISLAND.cpp--island_algorithm--ERROR] need at least 2 islands and an even population, and each island must hold more chromosomes than migrants\n");
+		exit(EXIT_FAILURE);
+	}
+
+	shared.graph = graph;
+	shared.config = config;
+	shared.mailboxes = new Mailbox[(size_t)island_number * island_number];
+	shared.solved = 0;
+
+	if (islands == NULL || positions == NULL || orders == NULL) {
+		printf("[ISLAND.cpp--island_algorithm--ERROR] cannot allocate memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/*
+	** only the mailboxes the topology can use get storage.
+	*/
+	for (int from = 0; from < island_number; from++) {
+		for (int to = 0; to < island_number; to++) {
+			Mailbox *mailbox = mailbox_of(&shared, from, to);
+			int used = config->topology == TOPOLOGY_RANDOM ? from != to : to == (from + 1) % island_number;
+
+			mailbox->head = 0;
+			mailbox->tail = 0;
+			mailbox->genes = NULL;
+			if (used && (mailbox->genes = (char *)malloc(MAILBOX_SLOTS * migration_size(&shared))) == NULL) {
+				printf("[ISLAND.cpp--island_algorithm--ERROR] cannot allocate memory\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+	}
+
+	start_time = time(NULL);
+	PROFILE_MARK(mark);
+
+	/*
+	** the island streams are split in island order before any island starts.
+	*/
+	for (int i = 0; i < island_number; i++) {
+		islands[i].shared = &shared;
+		islands[i].index = i;
+		islands[i].pop_size = island_size + (i < extra_pairs ? 2 : 0);
+		islands[i].order = orders + first;
+		first += islands[i].pop_size;
+		rng_split(rng, &islands[i].rng);
+	}
+	if (pool != NULL) {
+		for (int i = 0; i < island_number; i++) {
+			thread_pool_submit(pool, island_task, islands + i);
+		}
+		thread_pool_wait(pool);
+	}
+	else {
+		for (int i = 0; i < island_number; i++) {
+			threads.push_back(std::thread(island_main, islands + i));
+		}
+		for (int i = 0; i < island_number; i++) {
+			threads[i].join();
+		}
+	}
+
+	end_time = time(NULL);
+
+	/*
+	** merge the island traces. the merged fitness of a generation is the best of all islands. an island's
+	** evaluation times between its change points are estimated from its mean evaluations per generation.
+	*/
+	trace_init(&trace, TRACE_STRIDE);
+	while (1) {
+		int generation = -1;
+		double best = 0.0;
+		double evals = 0.0;
+
+		/*the next generation in which any island changed*/
+		for (int i = 0; i < island_number; i++) {
+			Trace const *t = &islands[i].run.trace;
+			if (positions[i] < t->len && (generation < 0 || t->points[positions[i]].generation < generation)) {
+				generation = t->points[positions[i]].generation;
+			}
+		}
+		if (generation < 0) {
+			break;
+		}
+
+		for (int i = 0; i < island_number; i++) {
+			Trace const *t = &islands[i].run.trace;
+			GA_Run const *run = &islands[i].run;
+
+			while (positions[i] < t->len && t->points[positions[i]].generation <= generation) {
+				positions[i] += 1;
+			}
+			if (positions[i] > 0) {
+				Trace_Point const *point = t->points + positions[i] - 1;
+				best = point->fitness > best ? point->fitness : best;
+				evals += generation >= run->count ? run->eval_times :
+					point->eval_times + (double)(generation - point->generation) * run->eval_times / run->count;
+			}
+		}
+		trace_add(&trace, generation, evals, best);
+	}
+
+	/*
+	** evaluations add up, the best island gives the solution.
+	*/
+	result_record = result_create(node_number, trace.len);
+	memcpy(result_record->trace, trace.points, trace.len * sizeof(Trace_Point));
+	result_record->start_seconds = (long long)start_time;
+	result_record->end_seconds = (long long)end_time;
+	time_to_string(&start_time, result_record->start_time, sizeof result_record->start_time);
+	time_to_string(&end_time, result_record->end_time, sizeof result_record->end_time);
+	elapsed_times(&start_time, &end_time, result_record->s_elapsed_times);
+
+	result_record->eval_times = 0.0;
+	result_record->avoided_times = 0.0;
+	result_record->loop_times = 0;
+	for (int i = 0; i < island_number; i++) {
+		GA_Run const *run = &islands[i].run;
+
+		result_record->eval_times += run->eval_times;
+		result_record->avoided_times += run->avoided_times;
+		profile_merge(&result_record->profile, &run->profile);
+		if (run->count > result_record->loop_times) {
+			result_record->loop_times = run->count;
+		}
+		if (run->gbest > islands[best_island].run.gbest) {
+			best_island = i;
+		}
+	}
+
+	/*the islands ran side by side, they make one run whose wall time is the time of the whole archipelago*/
+	result_record->profile.runs = 1;
+#if GA_PROFILE
+	result_record->profile.total_ns = profile_now() - mark;
+#endif
+
+	GA_Run const *best_run = &islands[best_island].run;
+	result_record->success = best_run->gbest == 1.0;
+	memcpy(result_record->solution, best_run->parents->chromos[best_run->parent_best].solution, node_number);
+
+	for (int i = 0; i < island_number; i++) {
+		ga_run_free(&islands[i].run);
+	}
+	for (size_t k = 0; k < (size_t)island_number * island_number; k++) {
+		free(shared.mailboxes[k].genes);
+	}
+	delete[] shared.mailboxes;
+	free(islands);
+	free(positions);
+	free(orders);
+	trace_free(&trace);
+
+	return result_record;
+}
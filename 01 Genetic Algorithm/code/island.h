@@ -0,0 +1,37 @@
+#ifndef _HEADER_ISLAND_H
+#define _HEADER_ISLAND_H	1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rng.h"
+#include "problem.h"
+#include "geneticalgorithm.h"
+
+#define TOPOLOGY_RING	1	/*island i sends its migrants to island i + 1*/
+#define TOPOLOGY_RANDOM	2	/*each migration goes to an island drawn at random*/
+#define MIGRATION_INTERVAL	20	/*default number of generations between two migrations*/
+#define MIGRANT_NUMBER	2	/*default number of best chromosomes sent by one migration*/
+#define MAILBOX_SLOTS	4	/*migrations a mailbox can hold, a migration to a full mailbox is dropped*/
+
+/*settings of the island model*/
+typedef struct Island_Config {
+	int island_number;	/*number of islands, each island runs as a task of its own*/
+	int migration_interval;	/*number of generations between two migrations*/
+	int migrant_number;	/*number of best chromosomes sent by one migration*/
+	int topology;	/*TOPOLOGY_RING or TOPOLOGY_RANDOM*/
+} Island_Config;
+
+/*
+** island model genetic algorithm. the pop_size / 2 pairs of chromosomes are spread over the islands, which differ
+** by one pair at most. every island runs the genetic algorithm as a task of pool on a stream split from rng, and sends
+** its best chromosomes to a neighbour every migration interval. migrants go through lock-free mailboxes, so islands
+** never wait for each other and a pool with fewer workers than islands runs them in turns. pool is used by this run
+** alone, NULL means a thread of its own per island.
+** migrations arrive whenever their sender gets there, so unlike genetic_algorithm() a run is not repeatable.
+** every island runs with the operators of ga_config, NULL means the defaults.
+*/
+Result *island_algorithm(Graph const *graph, int pop_size, Island_Config const *config, GA_Config const *ga_config, Rng *rng, Thread_Pool *pool);
+
+#endif
@@ -0,0 +1,253 @@
+#include "kernels.h"
+
+#include <math.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define USE_X86_KERNELS	1	/*kernels for avx2 and avx512 are compiled with target attributes*/
+#include <immintrin.h>
+#else
+#define USE_X86_KERNELS	0
+#endif
+
+/*generate a random solution*/
+void random_genes(char *solution, int node_number, Rng *rng)
+{
+	rng_fill_below(rng, solution, node_number, 3);
+}
+
+/*
+** point crossover, genes before position come from the first parent. each child is two bulk copies.
+** return 0 if the children are copies of their first parents (the parents agree on the genes which are swapped)
+*/
+int point_crossover(int position, char const *parent1, char const *parent2, char *child1, char *child2, int node_number)
+{
+	memcpy(child1, parent1, position);
+	memcpy(child1 + position, parent2 + position, node_number - position);
+	memcpy(child2, parent2, position);
+	memcpy(child2 + position, parent1 + position, node_number - position);
+
+	return memcmp(parent1 + position, parent2 + position, node_number - position) != 0;
+}
+
+/*count the genes in which two solutions differ, counting stops once it exceeds limit*/
+int count_diff(char const *solution1, char const *solution2, int limit, int node_number)
+{
+	int diff = 0;
+
+	for (int i = 0; i < node_number && diff <= limit; i++) {
+		if (solution1[i] != solution2[i]) {
+			diff += 1;
+		}
+	}
+
+	return diff;
+}
+
+/*spread the 8 mask bits of 8 genes to the 8 gene bytes of a word, a set bit gives 0xff*/
+static inline uint64_t spread_bits(unsigned bits)
+{
+	uint64_t x = (bits * 0x0101010101010101ULL) & 0x8040201008040201ULL;	/*byte k keeps bit k*/
+	uint64_t m = (((x + 0x7f7f7f7f7f7f7f7fULL) & 0x8080808080808080ULL) >> 7) * 0xff;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	m = __builtin_bswap64(m);	/*gene k is the first byte of the word, not the lowest one*/
+#endif
+	return m;
+}
+
+/*mask crossover of genes first ... node_number - 1, 8 genes at a time in a 64-bit word. return 0 if no gene was swapped*/
+static int mask_crossover_words(int first, uint64_t const *mask, char const *parent1, char const *parent2, char *child1, char *child2, int node_number)
+{
+	int j = first;
+	uint64_t swapped = 0;
+
+	for (; j + 8 <= node_number; j += 8) {
+		uint64_t a;
+		uint64_t b;
+		uint64_t swap;
+
+		memcpy(&a, parent1 + j, 8);
+		memcpy(&b, parent2 + j, 8);
+		swap = (a ^ b) & spread_bits((unsigned)(mask[j / 64] >> (j % 64)) & 0xff);
+		swapped |= swap;
+		a ^= swap;
+		b ^= swap;
+		memcpy(child1 + j, &a, 8);
+		memcpy(child2 + j, &b, 8);
+	}
+	for (; j < node_number; j++) {
+		int bit = (int)(mask[j / 64] >> (j % 64)) & 1;
+
+		child1[j] = bit ? parent2[j] : parent1[j];
+		child2[j] = bit ? parent1[j] : parent2[j];
+		swapped |= (uint64_t)(bit && parent1[j] != parent2[j]);
+	}
+
+	return swapped != 0;
+}
+
+static int mask_crossover_portable(uint64_t const *mask, char const *parent1, char const *parent2, char *child1, char *child2, int node_number)
+{
+	return mask_crossover_words(0, mask, parent1, parent2, child1, child2, node_number);
+}
+
+#if USE_X86_KERNELS
+
+/*mask crossover of 32 genes at a time, the 32 mask bits are spread to bytes by a shuffle and a compare*/
+__attribute__((target("avx2")))
+static int mask_crossover_avx2(uint64_t const *mask, char const *parent1, char const *parent2, char *child1, char *child2, int node_number)
+{
+	__m256i const spread = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+		2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+	__m256i const select = _mm256_set1_epi64x((long long)0x8040201008040201ULL);
+	__m256i swapped = _mm256_setzero_si256();
+	int j = 0;
+
+	for (; j + 32 <= node_number; j += 32) {
+		__m256i m = _mm256_shuffle_epi8(_mm256_set1_epi32((int)(uint32_t)(mask[j / 64] >> (j % 64))), spread);
+		__m256i a = _mm256_loadu_si256((__m256i const *)(parent1 + j));
+		__m256i b = _mm256_loadu_si256((__m256i const *)(parent2 + j));
+
+		m = _mm256_cmpeq_epi8(_mm256_and_si256(m, select), select);
+		swapped = _mm256_or_si256(swapped, _mm256_and_si256(_mm256_xor_si256(a, b), m));
+		_mm256_storeu_si256((__m256i *)(child1 + j), _mm256_blendv_epi8(a, b, m));
+		_mm256_storeu_si256((__m256i *)(child2 + j), _mm256_blendv_epi8(b, a, m));
+	}
+
+	return mask_crossover_words(j, mask, parent1, parent2, child1, child2, node_number) | !_mm256_testz_si256(swapped, swapped);
+}
+
+/*mask crossover of 64 genes at a time, a mask word is the blend mask itself. the tail is loaded and stored with a mask*/
+__attribute__((target("avx512f,avx512bw")))
+static int mask_crossover_avx512(uint64_t const *mask, char const *parent1, char const *parent2, char *child1, char *child2, int node_number)
+{
+	__mmask64 swapped = 0;
+
+	for (int j = 0; j < node_number; j += 64) {
+		__mmask64 tail = node_number - j >= 64 ? ~0ULL : (1ULL << (node_number - j)) - 1;
+		__m512i a = _mm512_maskz_loadu_epi8(tail, parent1 + j);
+		__m512i b = _mm512_maskz_loadu_epi8(tail, parent2 + j);
+
+		_mm512_mask_storeu_epi8(child1 + j, tail, _mm512_mask_blend_epi8(mask[j / 64], a, b));
+		_mm512_mask_storeu_epi8(child2 + j, tail, _mm512_mask_blend_epi8(mask[j / 64], b, a));
+		swapped |= _mm512_mask_cmpneq_epi8_mask(mask[j / 64], a, b);
+	}
+
+	return swapped != 0;
+}
+
+#endif	/*USE_X86_KERNELS*/
+
+/*all mask crossover kernels, the fastest first*/
+static Cross_Kernels const cross_kernel_table[] = {
+#if USE_X86_KERNELS
+	{ "avx512", 64, mask_crossover_avx512 },
+	{ "avx2", 32, mask_crossover_avx2 },
+#endif
+	{ "portable", 0, mask_crossover_portable },
+};
+
+/*check whether this cpu supports the kernels*/
+static int cross_kernels_supported(Cross_Kernels const *kernels)
+{
+#if USE_X86_KERNELS
+	if (strcmp(kernels->name, "avx512") == 0) {
+		return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+	}
+	if (strcmp(kernels->name, "avx2") == 0) {
+		return __builtin_cpu_supports("avx2");
+	}
+#endif
+	return strcmp(kernels->name, "portable") == 0;
+}
+
+/*select the fastest mask crossover kernels this cpu supports for node_number genes*/
+Cross_Kernels const *select_cross_kernels(int node_number)
+{
+	int count = sizeof cross_kernel_table / sizeof cross_kernel_table[0];
+
+	for (int i = 0; i < count - 1; i++) {
+		if (node_number >= cross_kernel_table[i].min_genes && cross_kernels_supported(cross_kernel_table + i)) {
+			return cross_kernel_table + i;
+		}
+	}
+
+	return cross_kernel_table + count - 1;
+}
+
+/*find mask crossover kernels by name ("portable", "avx2" or "avx512"), NULL if this cpu does not support them*/
+Cross_Kernels const *find_cross_kernels(char const *name)
+{
+	for (unsigned i = 0; i < sizeof cross_kernel_table / sizeof cross_kernel_table[0]; i++) {
+		if (strcmp(cross_kernel_table[i].name, name) == 0) {
+			return cross_kernels_supported(cross_kernel_table + i) ? cross_kernel_table + i : NULL;
+		}
+	}
+
+	return NULL;
+}
+
+/*draw a random crossover mask of node_number genes, BIT_WORDS(node_number) words, one random number per 64 genes*/
+void random_mask(uint64_t *mask, int node_number, Rng *rng)
+{
+	for (int w = 0; w < BIT_WORDS(node_number); w++) {
+		mask[w] = rng_u64(rng);
+	}
+}
+
+/*
+** mutate each of count genes with probability m_rate to one of the two other colors. the gap to the next mutated gene
+** is drawn from the geometric distribution, so one random number is drawn per mutation, not per gene.
+** genes holds solutions of node_number genes one after another, dirty[k] is set to 1 if solution k is mutated.
+*/
+void mutate_genes(char *genes, long long count, double m_rate, Rng *rng, int node_number, char *dirty)
+{
+	double scale = 0.0;
+	long long i = 0;
+
+	if (m_rate <= 0.0) {
+		return;
+	}
+	scale = 1.0 / log1p(-m_rate);	/*-0 for m_rate 1, then every gap is 0*/
+
+	while (1) {
+		/*
+		** the high 53 bits give u in (0, 1], the gap floor(log(u) / log(1 - m_rate)) is geometric:
+		** P(gap = k) = (1 - m_rate)^k * m_rate, as if each gene were drawn on its own.
+		** the lowest bit picks one of the two other colors, so there is nothing to reject.
+		*/
+		uint64_t x = rng_u64(rng);
+		double u = ((x >> 11) + 1) * (1.0 / 9007199254740992.0);
+		double gap = floor(log(u) * scale);
+
+		if (gap >= (double)(count - i)) {
+			break;
+		}
+		i += (long long)gap;
+		genes[i] = (char)((genes[i] + 1 + (int)(x & 1)) % 3);
+		dirty[i / node_number] = 1;
+		i += 1;
+	}
+}
+
+/*hash of the genes of a solution, equal solutions have equal hashes*/
+uint64_t gene_hash(char const *solution, int node_number)
+{
+	uint64_t hash = (uint64_t)node_number * 0x9e3779b97f4a7c15ULL;
+	uint64_t word = 0;
+	int j = 0;
+
+	/*
+	** 8 genes at a time, each word is mixed in by a multiply and a shift.
+	*/
+	for (; j + 8 <= node_number; j += 8) {
+		memcpy(&word, solution + j, 8);
+		hash = (hash ^ word) * 0xbf58476d1ce4e5b9ULL;
+		hash ^= hash >> 31;
+	}
+	word = 0;
+	memcpy(&word, solution + j, node_number - j);
+	hash = (hash ^ word) * 0x94d049bb133111ebULL;
+
+	return hash ^ (hash >> 29);
+}
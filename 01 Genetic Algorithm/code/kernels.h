@@ -0,0 +1,58 @@
+#ifndef _HEADER_KERNELS_H
+#define _HEADER_KERNELS_H	1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "rng.h"
+#include "bitpack.h"
+
+/*generate a random solution*/
+void random_genes(char *solution, int node_number, Rng *rng);
+
+/*
+** point crossover, genes before position come from the first parent. each child is two bulk copies.
+** return 0 if the children are copies of their first parents (the parents agree on the genes which are swapped)
+*/
+int point_crossover(int position, char const *parent1, char const *parent2, char *child1, char *child2, int node_number);
+
+/*count the genes in which two solutions differ, counting stops once it exceeds limit*/
+int count_diff(char const *solution1, char const *solution2, int limit, int node_number);
+
+/*
+** mask crossover kernels of one instruction set. a mask has one bit per gene, gene j is bit j % 64 of mask[j / 64].
+** genes whose bit is 0 come from the first parent, the others from the second one.
+*/
+typedef struct cross_kernels {
+	char const *name;	/*name of instruction set*/
+	int min_genes;	/*shorter solutions are faster with narrower kernels*/
+
+	/*
+	** mask crossover, the children are blended from the parents a block of genes at a time.
+	** return 0 if the children are copies of their first parents (the parents agree on every gene whose bit is set)
+	*/
+	int(*mask_crossover)(uint64_t const *mask, char const *parent1, char const *parent2, char *child1, char *child2, int node_number);
+} Cross_Kernels;
+
+/*select the fastest mask crossover kernels this cpu supports for node_number genes*/
+Cross_Kernels const *select_cross_kernels(int node_number);
+
+/*find mask crossover kernels by name ("portable", "avx2" or "avx512"), NULL if this cpu does not support them*/
+Cross_Kernels const *find_cross_kernels(char const *name);
+
+/*draw a random crossover mask of node_number genes, BIT_WORDS(node_number) words, one random number per 64 genes*/
+void random_mask(uint64_t *mask, int node_number, Rng *rng);
+
+/*
+** mutate each of count genes with probability m_rate to one of the two other colors. the gap to the next mutated gene
+** is drawn from the geometric distribution, so one random number is drawn per mutation, not per gene.
+** genes holds solutions of node_number genes one after another, dirty[k] is set to 1 if solution k is mutated.
+*/
+void mutate_genes(char *genes, long long count, double m_rate, Rng *rng, int node_number, char *dirty);
+
+/*hash of the genes of a solution, equal solutions have equal hashes*/
+uint64_t gene_hash(char const *solution, int node_number);
+
+#endif
@@ -3,128 +3,232 @@
 #include <string.h>
 #include <time.h>
 
-#include "mt.h"
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "rng.h"
 #include "problem.h"
 #include "geneticalgorithm.h"
+#include "campaign.h"
+#include "graphio.h"
+#include "service.h"
 
 #define MAX_RUN	30
+#define DEFAULT_NODE_NUMBER	90	/*node number used when none is given*/
 #define D_NUM	11	/*length of d list*/
 #define SAVE_GRAPH	0	/*save graph or not*/
-#define SAVE_RESULTS	1	/*save results or not*/
-#define GRAPH_SAVE_PATH	"..\\graph\\"
-#define RESULTS_SAVE_PATH	"..\\results\\"
-#define FINAL_RESULT_PATH	"..\\final results\\"
+#define SAVE_GRAPH_BINARY	1	/*graphs are saved as binary graph files with their planted coloring (see graphio.h), 0 saves a text adjacency matrix*/
+#define SAVE_RESULTS	1	/*save results or not. all runs of a campaign go to one binary file*/
+#define SAVE_RESULTS_CSV	1	/*also write a csv summary line per run*/
+#define GRAPH_SAVE_PATH	"../graph/"	/*forward slashes work on both Windows and POSIX*/
+#define RESULTS_SAVE_PATH	"../results/"
+#define FINAL_RESULT_PATH	"../final results/"
+#define ISLAND_TOPOLOGY	TOPOLOGY_RING	/*topology of the island model, TOPOLOGY_RING or TOPOLOGY_RANDOM*/
+#define PRINT_RUN_PROFILE	0	/*print the profile of each run, only if GA_PROFILE is 1. the campaign profile is always printed then*/
 
 /*generate full record save path*/
 void generate_save_path(char *save_path, char const *save_directory, char const *file_name);
 
-int main()
+/*print the result of one run and save its graph, it is called by the campaign for each finished run. results are saved by the sink*/
+void report_run(int d_index, int run, Graph const *graph, Result const *result, void *user);
+
+/*things report_run needs to know about the campaign*/
+typedef struct Report_Context {
+	int node_number;
+	float const *d_list;
+	char const *const *s_d_list;
+} Report_Context;
+
+/*
+** usage: main [node number] [population size] [thread count] [run thread count] [island number] [key=value ...]
+** thread count 0 (default) means one thread per core. run thread count is the number of threads
+** which share the generations of one run, 1 (default) means each run stays on its own thread.
+** island number >= 2 splits the population of each run over that many islands, one thread each. thread count is then
+** shared out, so thread count / island number runs go side by side.
+** the word portfolio races the plain GA, the GA with hill climbing, the GA with the assessment strategy and
+** tabu search alone on each run, one thread each, and the first coloring wins (see portfolio.h).
+** key=value arguments set GA parameters (see config.h), config=path reads them from a file. they may be
+** mixed with the numbers above and are applied from left to right.
+** graph=path solves the graph of a file MAX_RUN times instead of random graphs, node number is then taken from the file.
+** a path ending with ".graph" is a binary graph file which is mapped (see graphio.h), anything else is read as DIMACS .col.
+** the word service turns the program into a solver service instead of a campaign: graph jobs are read from stdin and
+** solved by thread count workers, the replies go to stdout (see service.h). socket=path serves a unix domain socket at path instead.
+** the GA parameters are the base of the settings of each job.
+*/
+int main(int argc, char *argv[])
 {
-	setseed((unsigned)time(NULL));
+	char const *numbers[5] = { NULL };
+	int number_count = 0;
+	int use_portfolio = 0;
+	int use_service = 0;
+	char const *socket_path = NULL;
+	char const *graph_path = NULL;
+	Graph graph_file = {};	/*graph of graph=path*/
+	GA_Config config;
+
+	ga_config_default(&config);
+	for (int i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "config=", 7) == 0) {
+			ga_config_load(&config, argv[i] + 7);
+		}
+		else if (strncmp(argv[i], "socket=", 7) == 0) {
+			use_service = 1;
+			socket_path = argv[i] + 7;
+		}
+		else if (strncmp(argv[i], "graph=", 6) == 0) {
+			graph_path = argv[i] + 6;
+		}
+		else if (strchr(argv[i], '=') != NULL) {
+			ga_config_set(&config, argv[i]);
+		}
+		else if (strcmp(argv[i], "portfolio") == 0) {
+			use_portfolio = 1;
+		}
+		else if (strcmp(argv[i], "service") == 0) {
+			use_service = 1;
+		}
+		else if (number_count < 5) {
+			numbers[number_count++] = argv[i];
+		}
+	}
+	ga_config_check(&config);
+
+	int node_number = numbers[0] != NULL ? atoi(numbers[0]) : DEFAULT_NODE_NUMBER;
+	int pop_size = numbers[1] != NULL ? atoi(numbers[1]) : DEFAULT_POP_SIZE;
+	int thread_count = numbers[2] != NULL ? atoi(numbers[2]) : 0;
+	int run_thread_count = numbers[3] != NULL ? atoi(numbers[3]) : 1;
+	int island_number = numbers[4] != NULL ? atoi(numbers[4]) : 1;
+
+	/*
+	** in service mode stdout carries the replies, nothing else is printed.
+	*/
+	if (use_service) {
+		Solver_Service *service = service_create(thread_count, &config);
+		int status = EXIT_SUCCESS;
+
+		if (socket_path != NULL) {
+			status = service_listen(service, socket_path);
+		}
+		else {
+#ifdef _WIN32
+			_setmode(_fileno(stdin), _O_BINARY);
+			_setmode(_fileno(stdout), _O_BINARY);
+#endif
+			service_run(service, stdin, stdout);
+		}
+		service_destroy(service);
+		return status;
+	}
+
+	if (graph_path != NULL) {
+		graph_load(&graph_file, graph_path);
+		node_number = graph_file.node_number;
+	}
+	if ((graph_path == NULL && node_number < 3) || pop_size <= config.k_candidate || pop_size % 2 != 0) {
+		printf("[MAIN.cpp--main--ERROR] node number must be at least 3, population size must be even and larger than %d\n", config.k_candidate);
+		exit(EXIT_FAILURE);
+	}
 
-	char graph[NODE_NUMBER][NODE_NUMBER];
 	float d_list[D_NUM] = { 1.5, 2.0, 2.5, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0 };
-	char *s_d_list[] = { " d_15 ", " d_20 ", " d_25 ", " d_30 ", " d_40 ", " d_50 ",
+	char const *s_d_list[] = { " d_15 ", " d_20 ", " d_25 ", " d_30 ", " d_40 ", " d_50 ",
 		" d_60 ", " d_70 ", " d_80 ", " d_90 ", " d_100 ", };
-	int sr = 0;
-	double avg_eval_times = 0.0;
+	int d_number = D_NUM;
 	int sr_list[D_NUM] = { 0 };
 	double avg_eval_list[D_NUM] = { 0.0 };
 	char full_path[200] = "";
 	char file_name[100] = "";
+	char s_time[50] = "";
 	FILE *final_result = NULL;
+	Result_Sink *sink = NULL;
+	Profile profile;
+
+	Report_Context context = { node_number, d_list, s_d_list };
+	Island_Config islands = { island_number, MIGRATION_INTERVAL, MIGRANT_NUMBER, ISLAND_TOPOLOGY };
+	Portfolio_Config portfolio;
+	Campaign campaign;
+
+	/*
+	** the graph of a file is one d, its own density.
+	*/
+	if (graph_path != NULL) {
+		d_number = 1;
+		d_list[0] = (float)graph_file.edge_number / graph_file.node_number;
+		s_d_list[0] = " file ";
+	}
 
 	/*
 	** print start time.
 	*/
 	time_t current_time = time(NULL);
-	printf("Start---%s", ctime(&current_time));
+	time_to_string(&current_time, s_time, sizeof s_time);
+	printf("Start---%s", s_time);
+	ga_config_print(stdout, &config);
 
 	/*
-	** for each d ...
+	** one results sink per campaign, it writes on its own thread.
 	*/
-	for (int i = 0; i < D_NUM; i++) {
-		float d = d_list[i];
-		avg_eval_times = 0.0;
-		sr = 0;
-
-		printf("d = %f begin:\n", d);
-
-		/*
-		** for each try ...
-		*/
-		for (int k = 0; k < MAX_RUN; k++) {
-			/*
-			** generate random graph
-			*/
-			generate_random_graph(graph, d);
-			memset(full_path, 0, sizeof full_path);
-			memset(file_name, 0, sizeof file_name);
-
-			/*
-			** if save graph ...
-			*/
-			if (SAVE_GRAPH) {
-				strcpy(file_name, "graph90");
-				strcat(file_name, s_d_list[i]);
-				generate_save_path(full_path, GRAPH_SAVE_PATH, file_name);
-				save_graph(graph, full_path, ".csv");
-				memset(full_path, 0, sizeof full_path);
-				memset(file_name, 0, sizeof file_name);
-			}
-
-			/*
-			** run genetic algorithm
-			*/
-			Result *p_result = genetic_algorithm(graph);
-
-			/*
-			** print result
-			*/
-			if (p_result->success) {
-				printf("\t graph %3d ============> success\n", k);
-				sr += 1;
-				avg_eval_times += p_result->eval_times;
-			}
-			else {
-				printf("\t graph %3d ============> fail\n", k);
-			}
-
-			if (SAVE_RESULTS) {
-				strcpy(file_name, "result90");
-				strcat(file_name, s_d_list[i]);
-				generate_save_path(full_path, RESULTS_SAVE_PATH, file_name);
-				save_result(p_result, full_path);
-				memset(full_path, 0, sizeof full_path);
-				memset(file_name, 0, sizeof file_name);
-			}
+	if (SAVE_RESULTS) {
+		sprintf(file_name, "results %d ", node_number);
+		generate_save_path(full_path, RESULTS_SAVE_PATH, file_name);
+		sink = result_sink_open(full_path, SAVE_RESULTS_CSV, RESULTS_QUEUE);
+	}
 
-			/*
-			** ATTENTION: do NOT forget free malloc memory!
-			*/
-			free(p_result);
-		}
+	/*
+	** run all (d, run) jobs on a thread pool.
+	*/
+	campaign.node_number = node_number;
+	campaign.graph = graph_path != NULL ? &graph_file : NULL;
+	campaign.pop_size = pop_size;
+	campaign.max_run = MAX_RUN;
+	campaign.d_number = d_number;
+	campaign.d_list = d_list;
+	campaign.thread_count = thread_count;
+	campaign.run_thread_count = run_thread_count;
+	campaign.config = &config;
+	campaign.islands = island_number >= 2 ? &islands : NULL;
+	campaign.portfolio = use_portfolio ? &portfolio : NULL;
+	portfolio_default(&portfolio, &config);
+	campaign.seed = (unsigned long)current_time;
+	campaign.rng_kind = RNG_DEFAULT;
+	campaign.on_result = report_run;
+	campaign.user = &context;
+	campaign.sink = sink;
+	campaign.sr_list = sr_list;
+	campaign.avg_eval_list = avg_eval_list;
+	campaign.profile = GA_PROFILE ? &profile : NULL;
+	profile_clear(&profile);
 
-		if (sr > 0) {
-			sr_list[i] = sr;
-			avg_eval_list[i] = avg_eval_times / sr;
+	run_campaign(&campaign);
+	if (sink != NULL) {
+		result_sink_close(sink);
+	}
 
-			printf("d = %f finished. success: %d times, average evaluation times: %.6e\n\n", d, sr, avg_eval_list[i]);
+	for (int i = 0; i < d_number; i++) {
+		if (sr_list[i] > 0) {
+			printf("d = %f finished. success: %d times, average evaluation times: %.6e\n\n", d_list[i], sr_list[i], avg_eval_list[i]);
 		}
 	}
 
 	printf("all finish!\n\n");
 
+	if (GA_PROFILE) {
+		profile_print(stdout, &profile, "the campaign");
+		printf("\n");
+	}
+
 	/*
 	** print finish time
 	*/
 	current_time = time(NULL);
-	printf("End---%s", ctime(&current_time));
+	time_to_string(&current_time, s_time, sizeof s_time);
+	printf("End---%s", s_time);
 
 	/*
 	** save final result to csv file.
 	*/
-	strcpy(file_name, "final result 90");
+	sprintf(file_name, "final result %d", node_number);
 	generate_save_path(full_path, FINAL_RESULT_PATH, file_name);
 	strcat(full_path, ".csv");
 
@@ -133,15 +237,54 @@ int main()
 		exit(EXIT_FAILURE);
 	}
 
-	for (int i = 0; i < D_NUM; i++) {
+	for (int i = 0; i < d_number; i++) {
 		fprintf(final_result, "%f, %d, %.6e\n", d_list[i], sr_list[i], avg_eval_list[i]);
 	}
 
 	fclose(final_result);
+	graph_free(&graph_file);
 
 	return EXIT_SUCCESS;
 }
 
+/*print the result of one run and save its graph, it is called by the campaign for each finished run. results are saved by the sink*/
+void report_run(int d_index, int run, Graph const *graph, Result const *result, void *user)
+{
+	Report_Context const *context = (Report_Context const *)user;
+	char full_path[200] = "";
+	char file_name[100] = "";
+
+	/*
+	** print result
+	*/
+	printf("\t d = %f graph %3d ============> %s\n", context->d_list[d_index], run, result->success ? "success" : "fail");
+	if (GA_PROFILE && PRINT_RUN_PROFILE) {
+		profile_print(stdout, &result->profile, "the run");
+	}
+
+	/*
+	** runs finish in parallel, so the run index is part of the file name, otherwise runs finished in the same second overwrite each other.
+	*/
+	if (SAVE_GRAPH) {
+		sprintf(file_name, "graph%d%srun %d ", context->node_number, context->s_d_list[d_index], run);
+		generate_save_path(full_path, GRAPH_SAVE_PATH, file_name);
+		if (SAVE_GRAPH_BINARY) {
+			char *coloring = (char *)malloc(graph->node_number);
+			if (coloring == NULL) {
+				printf("[MAIN.cpp--report_run--ERROR] cannot allocate memory\n");
+				exit(EXIT_FAILURE);
+			}
+			planted_coloring(graph->node_number, coloring);
+			strcat(full_path, ".graph");
+			graph_save_binary(graph, full_path, coloring);
+			free(coloring);
+		}
+		else {
+			save_graph(graph, full_path, ".csv");
+		}
+	}
+}
+
 /*generate full record save path*/
 void generate_save_path(char *save_path, char const *save_directory, char const *file_name)
 {
@@ -149,7 +292,7 @@ void generate_save_path(char *save_path, char const *save_directory, char const
 	char time_string[50] = "";
 	char *p_colon = NULL;
 
-	strcpy(time_string, ctime(&current_time));
+	time_to_string(&current_time, time_string, sizeof time_string);
 	/*because time string is ended by "\n\0", we must remove the '\n'*/
 	time_string[strlen(time_string) - 1] = '\0';
 	/*colon (':') will be replaced by '-', otherwise the fopen function will fail*/
@@ -1,10 +1,11 @@
 #include "mt.h"
 
-static unsigned long mt[N_]; /* the array for the state vector  */
-static int mti = N_ + 1; /* mti==N+1 means mt[N] is not initialized */
+/* the state lives in Mt_State, mt and mti below are its fields */
+#define mt	(state->mt)
+#define mti	(state->mti)
 
 /* initializes mt[N] with a seed */
-void init_genrand(unsigned long s)
+void init_genrand(Mt_State *state, unsigned long s)
 {
 	mt[0] = s & 0xffffffffUL;
 	for (mti = 1; mti<N_; mti++) {
@@ -23,10 +24,10 @@ void init_genrand(unsigned long s)
 /* init_key is the array for initializing keys */
 /* key_length is its length */
 /* slight change for C++, 2004/2/26 */
-void init_by_array(unsigned long init_key[], int key_length)
+void init_by_array(Mt_State *state, unsigned long init_key[], int key_length)
 {
 	int i, j, k;
-	init_genrand(19650218UL);
+	init_genrand(state, 19650218UL);
 	i = 1; j = 0;
 	k = (N_>key_length ? N_ : key_length);
 	for (; k; k--) {
@@ -49,17 +50,17 @@ void init_by_array(unsigned long init_key[], int key_length)
 }
 
 /* generates a random number on [0,0xffffffff]-interval */
-unsigned long genrand_int32(void)
+unsigned long genrand_int32(Mt_State *state)
 {
 	unsigned long y;
-	static unsigned long mag01[2] = { 0x0UL, MATRIX_A };
+	static unsigned long const mag01[2] = { 0x0UL, MATRIX_A };
 	/* mag01[x] = x * MATRIX_A  for x=0,1 */
 
 	if (mti >= N_) { /* generate N words at one time */
 		int kk;
 
 		if (mti == N_ + 1)   /* if init_genrand() has not been called, */
-			init_genrand(5489UL); /* a default initial seed is used */
+			init_genrand(state, 5489UL); /* a default initial seed is used */
 
 		for (kk = 0; kk<N_ - M; kk++) {
 			y = (mt[kk] & UPPER_MASK) | (mt[kk + 1] & LOWER_MASK);
@@ -87,66 +88,39 @@ unsigned long genrand_int32(void)
 }
 
 /* generates a random number on [0,0x7fffffff]-interval */
-long genrand_int31(void)
+long genrand_int31(Mt_State *state)
 {
-	return (long)(genrand_int32() >> 1);
+	return (long)(genrand_int32(state) >> 1);
 }
 
 /* generates a random number on [0,1]-real-interval */
-double genrand_real1(void)
+double genrand_real1(Mt_State *state)
 {
-	return genrand_int32()*(1.0 / 4294967295.0);
+	return genrand_int32(state)*(1.0 / 4294967295.0);
 	/* divided by 2^32-1 */
 }
 
 /* generates a random number on [0,1)-real-interval */
-double genrand_real2(void)
+double genrand_real2(Mt_State *state)
 {
-	return genrand_int32()*(1.0 / 4294967296.0);
+	return genrand_int32(state)*(1.0 / 4294967296.0);
 	/* divided by 2^32 */
 }
 
 /* generates a random number on (0,1)-real-interval */
-double genrand_real3(void)
+double genrand_real3(Mt_State *state)
 {
-	return (((double)genrand_int32()) + 0.5)*(1.0 / 4294967296.0);
+	return (((double)genrand_int32(state)) + 0.5)*(1.0 / 4294967296.0);
 	/* divided by 2^32 */
 }
 
 /* generates a random number on [0,1) with 53-bit resolution*/
-double genrand_res53(void)
+double genrand_res53(Mt_State *state)
 {
-	unsigned long a = genrand_int32() >> 5, b = genrand_int32() >> 6;
+	unsigned long a = genrand_int32(state) >> 5, b = genrand_int32(state) >> 6;
 	return(a*67108864.0 + b)*(1.0 / 9007199254740992.0);
 }
 /* These real versions are due to Isaku Wada, 2002/01/09 added */
 
-/*set seed for random generator*/
-void setseed(unsigned int seed)
-{
-#if USE_MT
-	init_genrand((unsigned long)seed);
-#else
-	srand(seed);
-#endif
-}
-
-/*generate a integer random number*/
-unsigned long randi(void)
-{
-#if USE_MT
-	return genrand_int32();
-#else
-	return rand();
-#endif
-}
-
-/*generate a double random number between 0 and 1*/
-double randf(void)
-{
-#if USE_MT
-	return genrand_real1();
-#else
-	return (rand()/(double)RAND_MAX);
-#endif
-}
\ No newline at end of file
+#undef mt
+#undef mti
@@ -11,42 +11,37 @@
 #define UPPER_MASK 0x80000000UL /* most significant w-r bits */
 #define LOWER_MASK 0x7fffffffUL /* least significant r bits */
 
-#define USE_MT	1	/*use mt or not. by setting this macro to 0, we use rand function in stdlib.h*/
+/* state of one generator, so every owner has its own stream */
+typedef struct mt_state {
+	unsigned long mt[N_]; /* the array for the state vector  */
+	int mti; /* mti==N+1 means mt[N] is not initialized */
+} Mt_State;
 
 /* initializes mt[N] with a seed */
-void init_genrand(unsigned long s);
+void init_genrand(Mt_State *state, unsigned long s);
 
 /* initialize by an array with array-length */
 /* init_key is the array for initializing keys */
 /* key_length is its length */
 /* slight change for C++, 2004/2/26 */
-void init_by_array(unsigned long init_key[], int key_length);
+void init_by_array(Mt_State *state, unsigned long init_key[], int key_length);
 
 /* generates a random number on [0,0xffffffff]-interval */
-unsigned long genrand_int32(void);
+unsigned long genrand_int32(Mt_State *state);
 
 /* generates a random number on [0,0x7fffffff]-interval */
-long genrand_int31(void);
+long genrand_int31(Mt_State *state);
 
 /* generates a random number on [0,1]-real-interval */
-double genrand_real1(void);
+double genrand_real1(Mt_State *state);
 
 /* generates a random number on [0,1)-real-interval */
-double genrand_real2(void);
+double genrand_real2(Mt_State *state);
 
 /* generates a random number on (0,1)-real-interval */
-double genrand_real3(void);
+double genrand_real3(Mt_State *state);
 
 /* generates a random number on [0,1) with 53-bit resolution*/
-double genrand_res53(void);
-
-/*set seed for random generator*/
-void setseed(unsigned int seed);
-
-/*generate a integer random number*/
-unsigned long randi(void);
-
-/*generate a double random number between 0 and 1*/
-double randf(void);
+double genrand_res53(Mt_State *state);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,292 @@
+#include "portfolio.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/*shared state of a portfolio run*/
+typedef struct Race {
+	Graph const *graph;
+	std::atomic<int> solved;	/*0 until a solver colors the graph, then the index of that solver + 1. every solver stops then*/
+} Race;
+
+/*one solver of a race and what it found*/
+typedef struct Racer {
+	Race *race;
+	int index;
+	Portfolio_Solver const *solver;
+	int pop_size;	/*population size of a GA solver*/
+	Rng rng;	/*stream of the solver, split from the run's stream*/
+	GA_Run run;	/*run of a GA solver*/
+	Tabu_Search tabu;	/*workspace of a tabu solver*/
+	char *solution;	/*coloring of a tabu solver*/
+	Conflict_State state;	/*conflict state of the coloring of a tabu solver*/
+	Trace own_trace;	/*convergence trace of a tabu solver*/
+
+	/*
+	** what the solver found, they are set when it stops whatever its kind.
+	*/
+	int count;	/*generations of a GA, searches of a tabu solver*/
+	double gbest;	/*best fitness*/
+	double eval_times;
+	double avoided_times;
+	Trace const *trace;
+	char const *best;	/*best solution*/
+	Profile profile;
+} Racer;
+
+/*claim the race for racer if nobody colored the graph before, the other solvers see the flag in their main loops*/
+static void claim_race(Racer *racer)
+{
+	int nobody = 0;
+
+	racer->race->solved.compare_exchange_strong(nobody, racer->index + 1, std::memory_order_relaxed);
+}
+
+/*whether any solver colored the graph*/
+static int race_over(Race const *race)
+{
+	return race->solved.load(std::memory_order_relaxed) != 0;
+}
+
+/*main loop of a GA solver, the solved flag is checked every generation and every move of a tabu hybrid*/
+static void ga_racer(Racer *racer)
+{
+	Race *race = racer->race;
+	GA_Run *run = &racer->run;
+
+	ga_run_init(run, race->graph, racer->pop_size, &racer->solver->config, &racer->rng, NULL);
+	run->tabu.stop = &race->solved;
+
+	while (run->count < run->config.max_loop && run->gbest != 1.0 && !race_over(race)) {
+		ga_run_step(run);
+	}
+	if (run->gbest == 1.0) {
+		claim_race(racer);
+	}
+
+	racer->count = run->count;
+	racer->gbest = run->gbest;
+	racer->eval_times = run->eval_times;
+	racer->avoided_times = run->avoided_times;
+	racer->trace = &run->trace;
+	racer->best = run->parents->chromos[run->parent_best].solution;
+	racer->profile = run->profile;
+}
+
+/*
+** main loop of a tabu solver: a random coloring, then up to max_loop searches of tabu_iterations moves each.
+** every search goes on from the best coloring of the one before, and checks the solved flag before each move.
+*/
+static void tabu_racer(Racer *racer)
+{
+	Race *race = racer->race;
+	Graph const *graph = race->graph;
+	GA_Config const *config = &racer->solver->config;
+	int node_number = graph->node_number;
+
+	racer->solution = (char *)malloc(node_number);
+	racer->state.node_conflicts = (int *)malloc(node_number * sizeof(int));
+	if (racer->solution == NULL || racer->state.node_conflicts == NULL) {
+		printf("[PORTFOLIO.cpp--tabu_racer--ERROR] cannot allocate memory\n");
+		exit(EXIT_FAILURE);
+	}
+	tabu_init(&racer->tabu, node_number);
+	racer->tabu.stop = &race->solved;
+	trace_init(&racer->own_trace, TRACE_STRIDE);
+	profile_clear(&racer->profile);
+	racer->profile.runs = 1;
+
+	random_genes(racer->solution, node_number, &racer->rng);
+	conflict_state_init(graph, racer->solution, &racer->state);
+	racer->count = 0;
+	racer->eval_times = 1.0;
+	racer->avoided_times = 0.0;
+	racer->gbest = conflict_state_fitness(&racer->state);
+	trace_add(&racer->own_trace, 0, racer->eval_times, racer->gbest);
+
+	while (racer->count < config->max_loop && racer->state.conflict > 0 && !race_over(race)) {
+		PROFILE_MARK(mark);
+		int moves = tabu_search(&racer->tabu, graph, racer->solution, &racer->state,
+			config->tabu_iterations, config->tabu_tenure, config->tabu_alpha, &racer->rng);
+
+		racer->count += 1;
+		racer->eval_times += moves;
+		racer->gbest = conflict_state_fitness(&racer->state);
+		trace_add(&racer->own_trace, racer->count, racer->eval_times, racer->gbest);
+		PROFILE_COUNT(&racer->profile, evaluations, moves);
+		PROFILE_COUNT(&racer->profile, ls_moves, moves);
+		PROFILE_COUNT(&racer->profile, generations, 1);
+		PROFILE_LAP(&racer->profile, PHASE_LOCAL_SEARCH, mark);
+	}
+	if (racer->state.conflict == 0) {
+		claim_race(racer);
+	}
+
+	racer->trace = &racer->own_trace;
+	racer->best = racer->solution;
+}
+
+/*thread of one solver*/
+static void racer_main(Racer *racer)
+{
+	if (racer->solver->kind == SOLVER_TABU) {
+		tabu_racer(racer);
+	}
+	else {
+		ga_racer(racer);
+	}
+}
+
+/*release the memory held by a solver*/
+static void racer_free(Racer *racer)
+{
+	if (racer->solver->kind == SOLVER_TABU) {
+		free(racer->solution);
+		free(racer->state.node_conflicts);
+		tabu_free(&racer->tabu);
+		trace_free(&racer->own_trace);
+	}
+	else {
+		ga_run_free(&racer->run);
+	}
+}
+
+/*
+** set portfolio to the default solvers, all with the parameters of base (NULL means the defaults):
+** the plain GA, the GA with hill climbing, the GA with the assessment strategy and tabu search alone.
+*/
+void portfolio_default(Portfolio_Config *portfolio, GA_Config const *base)
+{
+	GA_Config config;
+
+	if (base != NULL) {
+		config = *base;
+	}
+	else {
+		ga_config_default(&config);
+	}
+
+	portfolio->solver_number = 4;
+	for (int i = 0; i < portfolio->solver_number; i++) {
+		portfolio->solvers[i].kind = SOLVER_GA;
+		portfolio->solvers[i].config = config;
+	}
+	portfolio->solvers[0].config.use_hybrid = 0;
+	portfolio->solvers[1].config.use_hybrid = 1;
+	portfolio->solvers[1].config.hybrid = 2;
+	portfolio->solvers[2].config.use_hybrid = 1;
+	portfolio->solvers[2].config.hybrid = 1;
+	portfolio->solvers[3].kind = SOLVER_TABU;
+}
+
+/*
+** portfolio solver: every solver runs on its own thread and stream split from rng, with pop_size chromosomes if it is a GA.
+** they share a solved flag which each of them checks in its main loop: the first one which colors the graph wins and
+** the others stop. the result is the trace and solution of the winner (the best solver if none wins), evaluations add up.
+** like the island model a run is not repeatable. the index of the solver of the result is put in winner if it is not NULL.
+*/
+Result *portfolio_algorithm(Graph const *graph, int pop_size, Portfolio_Config const *config, Rng *rng, int *winner)
+{
+	int node_number = graph->node_number;
+	int solver_number = config->solver_number;
+	Result *result_record = NULL;
+	Race race;
+	Racer *racers = (Racer *)calloc(solver_number > 0 ? solver_number : 1, sizeof(Racer));
+	std::vector<std::thread> threads;
+	int best_racer = 0;
+
+	time_t start_time;
+	time_t end_time;
+
+	if (racers == NULL) {
+		printf("[PORTFOLIO.cpp--portfolio_algorithm--ERROR] cannot allocate memory\n");
+		exit(EXIT_FAILURE);
+	}
+	if (solver_number < 1 || solver_number > MAX_SOLVERS) {
+		printf("[PORTFOLIO.cpp--portfolio_algorithm--ERROR] a portfolio needs 1 ... %d solvers\n", MAX_SOLVERS);
+		exit(EXIT_FAILURE);
+	}
+	for (int i = 0; i < solver_number; i++) {
+		if (config->solvers[i].kind != SOLVER_GA && config->solvers[i].kind != SOLVER_TABU) {
+			printf("[PORTFOLIO.cpp--portfolio_algorithm--ERROR] solver %d is neither SOLVER_GA nor SOLVER_TABU\n", i);
+			exit(EXIT_FAILURE);
+		}
+		ga_config_check(&config->solvers[i].config);
+	}
+
+	race.graph = graph;
+	race.solved = 0;
+
+	start_time = time(NULL);
+	PROFILE_MARK(mark);
+
+	/*
+	** the solver streams are split in solver order before any solver starts.
+	*/
+	for (int i = 0; i < solver_number; i++) {
+		racers[i].race = &race;
+		racers[i].index = i;
+		racers[i].solver = config->solvers + i;
+		racers[i].pop_size = pop_size;
+		rng_split(rng, &racers[i].rng);
+	}
+	for (int i = 0; i < solver_number; i++) {
+		threads.push_back(std::thread(racer_main, racers + i));
+	}
+	for (int i = 0; i < solver_number; i++) {
+		threads[i].join();
+	}
+
+	end_time = time(NULL);
+
+	/*
+	** the winner gives the trace and the solution, without one the solver with the best fitness does.
+	*/
+	if (race_over(&race)) {
+		best_racer = race.solved.load() - 1;
+	}
+	else {
+		for (int i = 1; i < solver_number; i++) {
+			if (racers[i].gbest > racers[best_racer].gbest) {
+				best_racer = i;
+			}
+		}
+	}
+	Racer const *best = racers + best_racer;
+
+	result_record = result_create(node_number, best->trace->len);
+	memcpy(result_record->trace, best->trace->points, best->trace->len * sizeof(Trace_Point));
+	memcpy(result_record->solution, best->best, node_number);
+	result_record->start_seconds = (long long)start_time;
+	result_record->end_seconds = (long long)end_time;
+	time_to_string(&start_time, result_record->start_time, sizeof result_record->start_time);
+	time_to_string(&end_time, result_record->end_time, sizeof result_record->end_time);
+	elapsed_times(&start_time, &end_time, result_record->s_elapsed_times);
+	result_record->success = best->gbest == 1.0;
+	result_record->loop_times = best->count;
+	result_record->eval_times = 0.0;
+	result_record->avoided_times = 0.0;
+	for (int i = 0; i < solver_number; i++) {
+		result_record->eval_times += racers[i].eval_times;
+		result_record->avoided_times += racers[i].avoided_times;
+		profile_merge(&result_record->profile, &racers[i].profile);
+	}
+
+	/*the solvers ran side by side, they make one run whose wall time is the time of the whole race*/
+	result_record->profile.runs = 1;
+#if GA_PROFILE
+	result_record->profile.total_ns = profile_now() - mark;
+#endif
+
+	if (winner != NULL) {
+		*winner = best_racer;
+	}
+
+	for (int i = 0; i < solver_number; i++) {
+		racer_free(racers + i);
+	}
+	free(racers);
+
+	return result_record;
+}
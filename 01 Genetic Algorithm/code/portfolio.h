@@ -0,0 +1,42 @@
+#ifndef _HEADER_PORTFOLIO_H
+#define _HEADER_PORTFOLIO_H	1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rng.h"
+#include "problem.h"
+#include "geneticalgorithm.h"
+
+#define SOLVER_GA	1	/*genetic algorithm with the operators of its config, including its hybrid*/
+#define SOLVER_TABU	2	/*tabu search alone, max_loop searches of tabu_iterations moves, each one goes on from the best coloring so far*/
+#define MAX_SOLVERS	8	/*largest number of solvers of a portfolio*/
+
+/*one solver of a portfolio*/
+typedef struct Portfolio_Solver {
+	int kind;	/*SOLVER_GA or SOLVER_TABU*/
+	GA_Config config;	/*operators and parameters of the solver, a tabu solver reads max_loop and the tabu parameters*/
+} Portfolio_Solver;
+
+/*solvers which race each other on the same graph*/
+typedef struct Portfolio_Config {
+	int solver_number;
+	Portfolio_Solver solvers[MAX_SOLVERS];
+} Portfolio_Config;
+
+/*
+** set portfolio to the default solvers, all with the parameters of base (NULL means the defaults):
+** the plain GA, the GA with hill climbing, the GA with the assessment strategy and tabu search alone.
+*/
+void portfolio_default(Portfolio_Config *portfolio, GA_Config const *base);
+
+/*
+** portfolio solver: every solver runs on its own thread and stream split from rng, with pop_size chromosomes if it is a GA.
+** they share a solved flag which each of them checks in its main loop: the first one which colors the graph wins and
+** the others stop. the result is the trace and solution of the winner (the best solver if none wins), evaluations add up.
+** like the island model a run is not repeatable. the index of the solver of the result is put in winner if it is not NULL.
+*/
+Result *portfolio_algorithm(Graph const *graph, int pop_size, Portfolio_Config const *config, Rng *rng, int *winner);
+
+#endif
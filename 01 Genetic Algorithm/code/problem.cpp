@@ -1,117 +1,276 @@
 #include "problem.h"
-#include "mt.h"
+#include "rng.h"
+#include "bitpack.h"
+#include "graphio.h"
 
-/*Given the node number and constraint density d, generate a random graph*/
-void generate_random_graph(char(*graph)[NODE_NUMBER], float d)
+/*make sure graph can hold node_number nodes and edge_number links. a graph set to { 0 } can be passed at the first time. a mapped graph is unmapped*/
+void graph_reserve(Graph *graph, int node_number, int edge_number)
 {
-	unsigned int total_links = (unsigned int)(NODE_NUMBER * d);	/*the total number of links in graph*/
-	char part1[NODE_NUMBER / 3][NODE_NUMBER / 3] = { { 0 } };	/*subgraph 1*/
-	char part2[NODE_NUMBER / 3][NODE_NUMBER / 3] = { { 0 } };	/*subgraph 2*/
-	char part3[NODE_NUMBER / 3][NODE_NUMBER / 3] = { { 0 } };	/*subgraph 3*/
+	graph_unmap(graph);
 
-	int k = NODE_NUMBER / 3;	/*the node number of each subgraph*/
-	unsigned int current_links = 0; /*the current number of links*/
+	if (graph->node_capacity < node_number) {
+		int *offsets = (int *)realloc(graph->offsets, (node_number + 1) * sizeof(int));
+		if (offsets == NULL) {
+			printf("[PROBLEM.CPP--graph_reserve--ERROR] cannot allocate memory\n");
+			exit(EXIT_FAILURE);
+		}
+		graph->offsets = offsets;
+		graph->node_capacity = node_number;
+	}
 
-	/*
-	** before generating, we initial the graph to "0"
-	*/
-	memset(graph, 0, sizeof graph);
+	if (graph->edge_capacity < edge_number) {
+		int *neighbours = (int *)realloc(graph->neighbours, 2 * (size_t)edge_number * sizeof(int));
+		if (neighbours == NULL) {
+			printf("[PROBLEM.CPP--graph_reserve--ERROR] cannot allocate memory\n");
+			exit(EXIT_FAILURE);
+		}
+		graph->neighbours = neighbours;
+		graph->edge_capacity = edge_number;
+	}
+}
+
+/*
+** check an edge list for graph_build: return NULL if every link joins two different nodes of 0 ... node_number - 1, else what is wrong.
+** repeated links are found by check_repeated_links once the graph is built.
+*/
+char const *check_links(int node_number, int edge_number, int const *edges)
+{
+	for (int k = 0; k < edge_number; k++) {
+		int u = edges[2 * k];
+		int v = edges[2 * k + 1];
+
+		if (u < 0 || u >= node_number || v < 0 || v >= node_number || u == v) {
+			return "a link is a self link or has an end which is not a node";
+		}
+	}
+	return NULL;
+}
 
+/*
+** check the adjacency lists of graph in O(nodes + links): return NULL if no link is repeated, else what is wrong.
+** marks is a workspace of node number ints, its contents are not kept.
+*/
+char const *check_repeated_links(Graph const *graph, int *marks)
+{
 	/*
-	** initialize 3 parts with some elements set to 1, which means adding edges to each subgraph.
+	** marks[v] is the last node whose list had v, so v is seen twice in one list if it is already marked with that node.
 	*/
-	for (int i = 0; i < k; i++) {
-		for (int j = 0; j < k; j++) {
-			if (randi() % 2 == 1) {
-				part1[i][j] = 1; current_links += 1;
-			}
-		}
+	for (int i = 0; i < graph->node_number; i++) {
+		marks[i] = -1;
 	}
-	for (int i = 0; i < k; i++) {
-		for (int j = 0; j < k; j++) {
-			if (randi() % 2 == 1) {
-				part2[i][j] = 1; current_links += 1;
+	for (int i = 0; i < graph->node_number; i++) {
+		for (int j = graph->offsets[i]; j < graph->offsets[i + 1]; j++) {
+			int neighbour = graph->neighbours[j];
+
+			if (marks[neighbour] == i) {
+				return "a link is repeated";
 			}
+			marks[neighbour] = i;
 		}
 	}
-	for (int i = 0; i < k; i++) {
-		for (int j = 0; j < k; j++) {
-			if (randi() % 2 == 1) {
-				part3[i][j] = 1; current_links += 1;
-			}
-		}
+	return NULL;
+}
+
+/*
+** build graph from an edge list, edges[2 * k] and edges[2 * k + 1] are the two ends of link k. bitset adjacency is built too if it pays off.
+** the links must be distinct, a repeated link is counted twice by the adjacency lists but once by the bitset adjacency.
+*/
+void graph_build(Graph *graph, int node_number, int edge_number, int const *edges)
+{
+	int *offsets = NULL;
+
+	graph_reserve(graph, node_number, edge_number);
+	graph->node_number = node_number;
+	graph->edge_number = edge_number;
+	offsets = graph->offsets;
+
+	/*
+	** count the degree of each node into offsets[i + 1], then accumulate them into start positions.
+	*/
+	memset(offsets, 0, (node_number + 1) * sizeof(int));
+	for (int k = 0; k < edge_number; k++) {
+		offsets[edges[2 * k] + 1] += 1;
+		offsets[edges[2 * k + 1] + 1] += 1;
+	}
+	for (int i = 0; i < node_number; i++) {
+		offsets[i + 1] += offsets[i];
 	}
 
 	/*
-	** if the current number of links are not equal to the total links, add or remove some links randomly.
+	** fill adjacency lists. offsets[i] is used as the write cursor of node i, so after filling,
+	** offsets[i] points to the end of list i, which is the start of list i + 1.
 	*/
-	while (current_links != total_links) {
-		int part_number = randi() % 3;
-		int i = randi() % k;
-		int j = randi() % k;
-
-		switch (part_number)
-		{
-		case 0:
-			if (current_links > total_links && part1[i][j] == 1) {
-				part1[i][j] = 0; current_links -= 1;
-			}
-			else if (current_links < total_links && part1[i][j] == 0) {
-				part1[i][j] = 1; current_links += 1;
-			}
-			
-			break;
-		case 1:
-			if (current_links > total_links && part2[i][j] == 1) {
-				part2[i][j] = 0; current_links -= 1;
-			}
-			else if (current_links < total_links && part2[i][j] == 0) {
-				part2[i][j] = 1; current_links += 1;
-			}
+	for (int k = 0; k < edge_number; k++) {
+		int u = edges[2 * k];
+		int v = edges[2 * k + 1];
+		graph->neighbours[offsets[u]++] = v;
+		graph->neighbours[offsets[v]++] = u;
+	}
+	for (int i = node_number; i > 0; i--) {
+		offsets[i] = offsets[i - 1];
+	}
+	offsets[0] = 0;
 
-			break;
-		case 2:
-			if (current_links > total_links && part3[i][j] == 1) {
-				part3[i][j] = 0; current_links -= 1;
-			}
-			else if (current_links < total_links && part3[i][j] == 0) {
-				part3[i][j] = 1; current_links += 1;
-			}
+	/*
+	** dense graphs are also kept as bitsets, then a full evaluation is a popcount per node.
+	*/
+	if (graph_bits_worthwhile(graph)) {
+		graph_build_bits(graph);
+	}
+	else {
+		graph_free_bits(graph);
+	}
+}
 
-			break;
-		default:
-			printf("[PROBLEM.CPP--generate_random_graph--ERROR] no such subgraph\n");
-			exit(EXIT_FAILURE);
-			break;
-		}
+/*release the memory held by graph*/
+void graph_free(Graph *graph)
+{
+	if (graph->mapping != NULL) {
+		graph_unmap(graph);
+	}
+	free(graph->offsets);
+	free(graph->neighbours);
+	free(graph->bit_rows);
+	memset(graph, 0, sizeof *graph);
+}
+
+/*set of cell indices with open addressing, it is used to sample distinct cells*/
+typedef struct Cell_Set {
+	uint64_t *slots;	/*CELL_EMPTY marks a free slot*/
+	uint64_t mask;	/*number of slots - 1, it is a power of 2*/
+} Cell_Set;
+
+#define CELL_EMPTY	UINT64_MAX
+
+/*allocate an empty set for count cells, it is kept at most half full*/
+static void cell_set_init(Cell_Set *set, uint64_t count)
+{
+	uint64_t size = 16;
+
+	while (size < 2 * count) {
+		size *= 2;
+	}
+	if ((set->slots = (uint64_t *)malloc(size * sizeof(uint64_t))) == NULL) {
+		printf("[PROBLEM.CPP--cell_set_init--ERROR] cannot allocate memory\n");
+		exit(EXIT_FAILURE);
+	}
+	memset(set->slots, 0xff, size * sizeof(uint64_t));
+	set->mask = size - 1;
+}
+
+/*slot of cell, or the free slot where it belongs*/
+static uint64_t *cell_set_find(Cell_Set const *set, uint64_t cell)
+{
+	uint64_t i = (cell * 0x9e3779b97f4a7c15ULL) >> 20 & set->mask;
+
+	while (set->slots[i] != CELL_EMPTY && set->slots[i] != cell) {
+		i = (i + 1) & set->mask;
+	}
+	return set->slots + i;
+}
+
+/*add cell to set, return 0 if it was already there*/
+static int cell_set_insert(Cell_Set *set, uint64_t cell)
+{
+	uint64_t *slot = cell_set_find(set, cell);
+
+	if (*slot == cell) {
+		return 0;
+	}
+	*slot = cell;
+	return 1;
+}
+
+/*
+** the links of the graph are cells of 3 k x k blocks: block 0 links part 1 to part 2, block 1 links part 1 to part 3
+** and block 2 links part 2 to part 3. write the two ends of the link of cell to edge.
+*/
+static void cell_to_edge(uint64_t cell, int k, int *edge)
+{
+	uint64_t block_size = (uint64_t)k * k;
+	int block = (int)(cell / block_size);
+	int i = (int)(cell % block_size / k);
+	int j = (int)(cell % k);
+
+	edge[0] = (block == 2 ? k : 0) + i;
+	edge[1] = (block == 0 ? k : 2 * k) + j;
+}
+
+/*
+** Given the node number and constraint density d, generate a random graph. the nodes are split into 3 parts of
+** node_number / 3 nodes (the rest stay isolated), and exactly node_number * d links are drawn uniformly from
+** the links between different parts, so the graph is 3-colorable. it costs O(links) time and memory.
+*/
+void generate_random_graph(Graph *graph, int node_number, float d, Rng *rng)
+{
+	int k = node_number / 3;	/*the node number of each part*/
+	uint64_t cell_number = 3 * (uint64_t)k * k;	/*the number of possible links*/
+	uint64_t total_links = (uint64_t)(node_number * d);	/*the total number of links in graph*/
+	int complement = total_links > cell_number / 2;	/*dense graphs draw the links they leave out*/
+	uint64_t draw_number = complement ? cell_number - total_links : total_links;
+	int *edges = NULL;	/*edge list of the graph*/
+	int count = 0;
+	Cell_Set set;
+
+	if (total_links > cell_number || total_links > (uint64_t)INT32_MAX / 2) {
+		printf("[PROBLEM.CPP--generate_random_graph--ERROR] %d nodes cannot have %.0f links\n", node_number, (double)total_links);
+		exit(EXIT_FAILURE);
+	}
+	if ((edges = (int *)malloc((2 * total_links + 1) * sizeof(int))) == NULL) {
+		printf("[PROBLEM.CPP--generate_random_graph--ERROR] cannot allocate memory\n");
+		exit(EXIT_FAILURE);
 	}
 
 	/*
-	** copy each part to the graph, note that the final graph is a symmetrical matrix, which
-	** means that this graph is undirected--if there is an edge between node i and node j, there
-	** is also an edge between node j and node i.
+	** draw draw_number distinct cells with Floyd's algorithm: one draw per cell, whatever was drawn before.
 	*/
-	for (int i = 0; i < k; i++) {
-		for (int j = k; j < 2 * k; j++) {
-			graph[j][i] = graph[i][j] = part1[i][j - k];
+	cell_set_init(&set, draw_number);
+	for (uint64_t j = cell_number - draw_number; j < cell_number; j++) {
+		uint64_t cell = rng_below64(rng, j + 1);
+
+		if (!cell_set_insert(&set, cell)) {
+			cell = j;
+			cell_set_insert(&set, cell);
 		}
-	}
-	for (int i = 0; i < k; i++) {
-		for (int j = 2 * k; j < NODE_NUMBER; j++) {
-			graph[j][i] = graph[i][j] = part2[i][j - 2 * k];
+		if (!complement) {
+			cell_to_edge(cell, k, edges + 2 * count);
+			count += 1;
 		}
 	}
-	for (int i = k; i < 2 * k; i++) {
-		for (int j = 2 * k; j < NODE_NUMBER; j++) {
-			graph[j][i] = graph[i][j] = part3[i - k][j - 2 * k];
+
+	/*
+	** a dense graph has every cell which was not drawn, there are at most twice as many cells as links.
+	*/
+	if (complement) {
+		for (uint64_t cell = 0; cell < cell_number; cell++) {
+			if (*cell_set_find(&set, cell) != cell) {
+				cell_to_edge(cell, k, edges + 2 * count);
+				count += 1;
+			}
 		}
 	}
+
+	graph_build(graph, node_number, count, edges);
+
+	free(set.slots);
+	free(edges);
+}
+
+/*write the planted coloring of the graphs of generate_random_graph: the color of a node is the part it belongs to*/
+void planted_coloring(int node_number, char *coloring)
+{
+	int k = node_number / 3;
+
+	for (int i = 0; i < node_number; i++) {
+		coloring[i] = (char)(k > 0 && i < 3 * k ? i / k : 0);
+	}
 }
 
 /*save graph to a file, if the file name or extension is set to NULL, they will be set to default values*/
-int save_graph(char const (*graph)[NODE_NUMBER], char const *filename, char const *extension)
+int save_graph(Graph const *graph, char const *filename, char const *extension)
 {
 	char file_name[200] = "";
+	char *row = NULL;	/*one row of adjacency matrix*/
 
 	FILE *file = NULL;
 
@@ -162,58 +321,78 @@ int save_graph(char const (*graph)[NODE_NUMBER], char const *filename, char cons
 		exit(EXIT_FAILURE);
 	}
 
-	for (int i = 0; i < NODE_NUMBER; i++) {
-		for (int j = 0; j < NODE_NUMBER; j++) {
-			fprintf(file, "%4d, ", graph[i][j]);
+	/*
+	** the graph is saved as an adjacency matrix, each row is expanded from the adjacency list of a node.
+	** a row is the text "   0, " per cell, so only the cells of the neighbours change and a row is written at once.
+	*/
+	if ((row = (char *)malloc(6 * (size_t)graph->node_number + 2)) == NULL) {
+		printf("[PROBLEM.CPP--save_graph--ERROR] cannot allocate memory.\n");
+		exit(EXIT_FAILURE);
+	}
+	for (int j = 0; j < graph->node_number; j++) {
+		memcpy(row + 6 * (size_t)j, "   0, ", 6);
+	}
+	row[6 * (size_t)graph->node_number] = '\n';
+
+	for (int i = 0; i < graph->node_number; i++) {
+		for (int k = graph->offsets[i]; k < graph->offsets[i + 1]; k++) {
+			row[6 * (size_t)graph->neighbours[k] + 3] = '1';
+		}
+		fwrite(row, 1, 6 * (size_t)graph->node_number + 1, file);
+		for (int k = graph->offsets[i]; k < graph->offsets[i + 1]; k++) {
+			row[6 * (size_t)graph->neighbours[k] + 3] = '0';
 		}
-		fprintf(file, "\n");
 	}
 	fprintf(file, "\n\n");
 
+	free(row);
 	fclose(file);
 
 	return EXIT_SUCCESS;
 }
 
 /*calculate the fitness of a solution*/
-double fitness(char const (*graph)[NODE_NUMBER], char const *solution)
+double fitness(Graph const *graph, char const *solution)
 {
-	unsigned int total_links = 0;
 	unsigned int conflict = 0;
 
-	/*because graph is a symmetric array, we just use the upper triangle data*/
-	for (int i = 0; i < NODE_NUMBER; i++) {
-		for (int j = i; j < NODE_NUMBER; j++) {
-			if (graph[i][j] == 1) {
-				total_links += 1;
-				if (solution[i] == solution[j]) {
-					conflict += 1;
-				}
+	if (graph->bit_rows != NULL) {
+		conflict = (unsigned int)bit_conflicts(graph->bit_kernels, graph, solution, NULL);
+		return 1.0 - (double)conflict / graph->edge_number;
+	}
+
+	/*because each link is stored twice, we just count it from its smaller end*/
+	for (int i = 0; i < graph->node_number; i++) {
+		for (int k = graph->offsets[i]; k < graph->offsets[i + 1]; k++) {
+			int j = graph->neighbours[k];
+			if (j > i && solution[i] == solution[j]) {
+				conflict += 1;
 			}
 		}
 	}
 
 	/*the fitness value is calculated below*/
-	return 1.0 - (double)conflict / total_links;
+	return 1.0 - (double)conflict / graph->edge_number;
 }
 
 /*given a graph and a solution, the conflict matrix is calculated. 
 conflict matrix is a matrix in which each row identifies those nodes whose colors conflict with current node.*/
-void generate_conflict_matrix(char const (*graph)[NODE_NUMBER], char const *solution, char(*conflict_matrix)[NODE_NUMBER])
+void generate_conflict_matrix(Graph const *graph, char const *solution, char *conflict_matrix)
 {
 	char current_node_color;
-	for (int i = 0; i < NODE_NUMBER; i++) {
+	for (int i = 0; i < graph->node_number; i++) {
 		current_node_color = solution[i];
-		for (int j = 0; j < NODE_NUMBER; j++) {
-			if (graph[i][j] == 1 && current_node_color == solution[j]) {
-				conflict_matrix[i][j] = 1;
+		for (int k = graph->offsets[i]; k < graph->offsets[i + 1]; k++) {
+			int j = graph->neighbours[k];
+			if (current_node_color == solution[j]) {
+				conflict_matrix[(size_t)i * graph->node_number + j] = 1;
 			}
 		}
 	}
 }
 
 /*for each node, calculate the number of conflict to other nodes, and return the "most conflict" node*/
-int solution_conflict(char const (*graph)[NODE_NUMBER], char const *solution, Conflict_Infor *conflict_infor)
+int solution_conflict(Graph const *graph, char const *solution, Conflict_Infor *conflict_infor)
 {
 	char current_node_color;
 	int current_node_conflict = 0;
@@ -224,21 +403,21 @@ int solution_conflict(char const (*graph)[NODE_NUMBER], char const *solution, Co
 	/*
 	** initialize  conflict information
 	*/
-	memset(conflict_infor->conflict_nodes, 0, NODE_NUMBER * sizeof(int));
-	memset(conflict_infor->conflict_numbers, 0, NODE_NUMBER * sizeof(int));
+	memset(conflict_infor->conflict_nodes, 0, graph->node_number * sizeof(int));
+	memset(conflict_infor->conflict_numbers, 0, graph->node_number * sizeof(int));
 	conflict_infor->len = 0;
 	conflict_infor->max_conflict_node = -1;
 	conflict_infor->max_conflict = 0;
 
-	for (int i = 0; i < NODE_NUMBER; i++) {
+	for (int i = 0; i < graph->node_number; i++) {
 		current_node_color = solution[i];
 		current_node_conflict = 0;
 
 		/*
 		** calculate the conflict of current node.
 		*/
-		for (int j = 0; j < NODE_NUMBER; j++) {
-			if (graph[i][j] == 1 && current_node_color == solution[j]) {
+		for (int k = graph->offsets[i]; k < graph->offsets[i + 1]; k++) {
+			if (current_node_color == solution[graph->neighbours[k]]) {
 				current_node_conflict += 1;
 			}
 		}
@@ -267,4 +446,135 @@ int solution_conflict(char const (*graph)[NODE_NUMBER], char const *solution, Co
 
 	/*if return -1, it means that no conflit in this graph*/
 	return max_conflict_index;
-}
\ No newline at end of file
+}
+
+/*build the conflict state of a solution from scratch*/
+void conflict_state_init(Graph const *graph, char const *solution, Conflict_State *state)
+{
+	int conflict = 0;
+
+	state->total_links = graph->edge_number;
+	if (graph->bit_rows != NULL) {
+		state->conflict = (int)bit_conflicts(graph->bit_kernels, graph, solution, state->node_conflicts);
+		return;
+	}
+
+	for (int i = 0; i < graph->node_number; i++) {
+		int node_conflict = 0;
+		for (int k = graph->offsets[i]; k < graph->offsets[i + 1]; k++) {
+			if (solution[i] == solution[graph->neighbours[k]]) {
+				node_conflict += 1;
+			}
+		}
+		state->node_conflicts[i] = node_conflict;
+		conflict += node_conflict;
+	}
+
+	/*each conflict link is counted from both of its ends*/
+	state->conflict = conflict / 2;
+}
+
+/*return the change of conflict links if node is recolored to color (negative means better). nothing is modified*/
+int conflict_state_delta(Graph const *graph, char const *solution, Conflict_State const *state, int node, char color)
+{
+	int new_conflict = 0;
+
+	if (solution[node] == color) {
+		return 0;
+	}
+
+	/*
+	** the links of node which conflict under the new color replace the ones which conflict under the old color.
+	*/
+	for (int k = graph->offsets[node]; k < graph->offsets[node + 1]; k++) {
+		if (solution[graph->neighbours[k]] == color) {
+			new_conflict += 1;
+		}
+	}
+
+	return new_conflict - state->node_conflicts[node];
+}
+
+/*recolor node to color and update the conflict state*/
+void conflict_state_recolor(Graph const *graph, char *solution, Conflict_State *state, int node, char color)
+{
+	char old_color = solution[node];
+	int new_conflict = 0;
+
+	if (old_color == color) {
+		return;
+	}
+
+	/*
+	** only the neighbours of node are affected.
+	*/
+	for (int k = graph->offsets[node]; k < graph->offsets[node + 1]; k++) {
+		int j = graph->neighbours[k];
+		if (solution[j] == old_color) {
+			state->node_conflicts[j] -= 1;
+		}
+		else if (solution[j] == color) {
+			state->node_conflicts[j] += 1;
+			new_conflict += 1;
+		}
+	}
+
+	state->conflict += new_conflict - state->node_conflicts[node];
+	state->node_conflicts[node] = new_conflict;
+	solution[node] = color;
+}
+
+/*move the conflict state of base solution to target solution by recoloring the genes they differ in. return the number of recolored genes*/
+int conflict_state_rebase(Graph const *graph, char const *base_solution, Conflict_State const *base_state,
+	char const *target_solution, Conflict_State *target_state)
+{
+	int count = 0;
+
+	conflict_state_copy(target_state, base_state, graph->node_number);
+
+	/*
+	** genes are recolored in order, so when node i is recolored, the nodes before i already have
+	** their target colors and the nodes after i still have their base colors.
+	*/
+	for (int i = 0; i < graph->node_number; i++) {
+		char old_color = base_solution[i];
+		char color = target_solution[i];
+		int new_conflict = 0;
+
+		if (old_color == color) {
+			continue;
+		}
+
+		for (int k = graph->offsets[i]; k < graph->offsets[i + 1]; k++) {
+			int j = graph->neighbours[k];
+			char neighbour_color = j < i ? target_solution[j] : base_solution[j];
+			if (neighbour_color == old_color) {
+				target_state->node_conflicts[j] -= 1;
+			}
+			else if (neighbour_color == color) {
+				target_state->node_conflicts[j] += 1;
+				new_conflict += 1;
+			}
+		}
+
+		target_state->conflict += new_conflict - target_state->node_conflicts[i];
+		target_state->node_conflicts[i] = new_conflict;
+		count += 1;
+	}
+
+	return count;
+}
+
+/*copy a conflict state into another one which has its own node conflicts storage*/
+void conflict_state_copy(Conflict_State *dst, Conflict_State const *src, int node_number)
+{
+	memcpy(dst->node_conflicts, src->node_conflicts, node_number * sizeof(int));
+	dst->conflict = src->conflict;
+	dst->total_links = src->total_links;
+}
+
+/*calculate the fitness of a conflict state, it is the same value as fitness() returns*/
+double conflict_state_fitness(Conflict_State const *state)
+{
+	return 1.0 - (double)state->conflict / state->total_links;
+}
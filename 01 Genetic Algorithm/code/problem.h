@@ -4,33 +4,100 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "mt.h"
+#include <stdint.h>
+#include "rng.h"
 
-#define NODE_NUMBER	90	/*number of graph nodes*/
+/*undirected graph in compressed sparse row form*/
+typedef struct graph {
+	int node_number;	/*number of nodes*/
+	int edge_number;	/*number of links, each link is stored twice in neighbours*/
+	int *offsets;	/*neighbours of node i are neighbours[offsets[i]] ... neighbours[offsets[i + 1] - 1]*/
+	int *neighbours;	/*adjacency lists of all nodes*/
+	int node_capacity;	/*number of nodes offsets can hold*/
+	int edge_capacity;	/*number of links neighbours can hold*/
+	int bit_words;	/*number of 64-bit words of each bitset row*/
+	uint64_t *bit_rows;	/*bitset adjacency, row i is bit_rows[i * bit_words] ... NULL if the graph is too sparse or too large for it*/
+	size_t bit_capacity;	/*number of words bit_rows can hold*/
+	struct bit_kernels const *bit_kernels;	/*popcount kernels for bitset rows, see bitpack.h*/
+	struct graph_mapping *mapping;	/*file mapping which offsets and neighbours point into, NULL if the graph owns them (see graphio.h)*/
+}Graph;
 
 /*give the conflict information of current solution*/
 typedef struct graph_conflict_list {
-	int conflict_nodes[NODE_NUMBER];	/*record the conflict indices (conflict nodes)*/
-	int conflict_numbers[NODE_NUMBER];	/*record the conflict number of each conflict node*/
+	int *conflict_nodes;	/*record the conflict indices (conflict nodes), it holds node number elements*/
+	int *conflict_numbers;	/*record the conflict number of each conflict node, it holds node number elements*/
 	int len;	/*the number of conflict nodes*/
 	int max_conflict_node;	/*max conflict node*/
 	int max_conflict;	/*max conflict*/
 }Conflict_Infor;
 
-/*Given the node number and constraint density d, generate a random graph*/
-void generate_random_graph(char(*graph)[NODE_NUMBER], float d);
+/*conflict state of one solution. it is updated node by node when a node is recolored, so a move costs O(degree) instead of a full fitness scan*/
+typedef struct conflict_state {
+	int *node_conflicts;	/*the number of neighbours which have the same color as each node, it holds node number elements*/
+	int conflict;	/*the number of conflict links*/
+	int total_links;	/*the number of links in graph*/
+}Conflict_State;
+
+/*make sure graph can hold node_number nodes and edge_number links. a graph set to { 0 } can be passed at the first time. a mapped graph is unmapped*/
+void graph_reserve(Graph *graph, int node_number, int edge_number);
+
+/*
+** check an edge list for graph_build: return NULL if every link joins two different nodes of 0 ... node_number - 1, else what is wrong.
+** repeated links are found by check_repeated_links once the graph is built.
+*/
+char const *check_links(int node_number, int edge_number, int const *edges);
+
+/*
+** check the adjacency lists of graph in O(nodes + links): return NULL if no link is repeated, else what is wrong.
+** marks is a workspace of node number ints, its contents are not kept.
+*/
+char const *check_repeated_links(Graph const *graph, int *marks);
+
+/*
+** build graph from an edge list, edges[2 * k] and edges[2 * k + 1] are the two ends of link k. bitset adjacency is built too if it pays off.
+** the links must be distinct, a repeated link is counted twice by the adjacency lists but once by the bitset adjacency.
+*/
+void graph_build(Graph *graph, int node_number, int edge_number, int const *edges);
+
+/*release the memory held by graph*/
+void graph_free(Graph *graph);
+
+/*Given the node number and constraint density d, generate a random 3-colorable graph with exactly node_number * d links in O(links)*/
+void generate_random_graph(Graph *graph, int node_number, float d, Rng *rng);
+
+/*write the planted coloring of the graphs of generate_random_graph: the color of a node is the part it belongs to*/
+void planted_coloring(int node_number, char *coloring);
 
 /*save graph to a file, if the file name or extension is set to NULL, they will be set to default values*/
-int save_graph(char const (*graph)[NODE_NUMBER], char const *filename, char const *extension);
+int save_graph(Graph const *graph, char const *filename, char const *extension);
 
 /*calculate the fitness of a solution*/
-double fitness(char const (*graph)[NODE_NUMBER], char const *solution);
+double fitness(Graph const *graph, char const *solution);
 
 /*given a graph and a solution, the conflict matrix is calculated.
-conflict matrix is a matrix in which each row identifies those nodes whose colors conflict with current node.*/
-void generate_conflict_matrix(char const (*graph)[NODE_NUMBER], char const *solution, char(*conflict_matrix)[NODE_NUMBER]);
+conflict matrix is a node number x node number matrix stored row by row, each row identifies those nodes whose colors conflict with current node.*/
+void generate_conflict_matrix(Graph const *graph, char const *solution, char *conflict_matrix);
 
 /*for each node, calculate the number of conflict to other nodes, and return the "most conflict" node*/
-int solution_conflict(char const (*graph)[NODE_NUMBER], char const *solution, Conflict_Infor *conflict_infor);
+int solution_conflict(Graph const *graph, char const *solution, Conflict_Infor *conflict_infor);
+
+/*build the conflict state of a solution from scratch*/
+void conflict_state_init(Graph const *graph, char const *solution, Conflict_State *state);
+
+/*return the change of conflict links if node is recolored to color (negative means better). nothing is modified*/
+int conflict_state_delta(Graph const *graph, char const *solution, Conflict_State const *state, int node, char color);
+
+/*recolor node to color and update the conflict state*/
+void conflict_state_recolor(Graph const *graph, char *solution, Conflict_State *state, int node, char color);
+
+/*move the conflict state of base solution to target solution by recoloring the genes they differ in. return the number of recolored genes*/
+int conflict_state_rebase(Graph const *graph, char const *base_solution, Conflict_State const *base_state,
+	char const *target_solution, Conflict_State *target_state);
+
+/*copy a conflict state into another one which has its own node conflicts storage*/
+void conflict_state_copy(Conflict_State *dst, Conflict_State const *src, int node_number);
+
+/*calculate the fitness of a conflict state, it is the same value as fitness() returns*/
+double conflict_state_fitness(Conflict_State const *state);
 
 #endif
\ No newline at end of file
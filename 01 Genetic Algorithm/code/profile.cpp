@@ -0,0 +1,55 @@
+#include "profile.h"
+
+/*set all times and counters of a profile to 0*/
+void profile_clear(Profile *profile)
+{
+	memset(profile, 0, sizeof *profile);
+}
+
+/*add the times and counters of src to dst*/
+void profile_merge(Profile *dst, Profile const *src)
+{
+	for (int i = 0; i < PHASE_NUMBER; i++) {
+		dst->phase_ns[i] += src->phase_ns[i];
+		dst->phase_calls[i] += src->phase_calls[i];
+	}
+	dst->total_ns += src->total_ns;
+	dst->runs += src->runs;
+	dst->generations += src->generations;
+	dst->evaluations += src->evaluations;
+	dst->avoided += src->avoided;
+	dst->ls_moves += src->ls_moves;
+}
+
+/*name of a phase*/
+char const *profile_phase_name(int phase)
+{
+	static char const *const names[PHASE_NUMBER] = {
+		"selection", "crossover", "mutation", "evaluation", "scaling", "elite", "local search"
+	};
+
+	return phase >= 0 && phase < PHASE_NUMBER ? names[phase] : "unknown";
+}
+
+/*print a profile as a table of phases followed by the rates, title names what it belongs to*/
+void profile_print(FILE *file, Profile const *profile, char const *title)
+{
+	long long phase_sum = 0;
+	double seconds = profile->total_ns * 1e-9;
+
+	for (int i = 0; i < PHASE_NUMBER; i++) {
+		phase_sum += profile->phase_ns[i];
+	}
+
+	fprintf(file, "profile of %s: %lld run(s), %lld generation(s), %.6f s\n", title, profile->runs, profile->generations, seconds);
+	fprintf(file, "\t%-14s %14s %8s %14s %12s\n", "phase", "seconds", "share", "calls", "ns/call");
+	for (int i = 0; i < PHASE_NUMBER; i++) {
+		fprintf(file, "\t%-14s %14.6f %7.2f%% %14lld %12.1f\n", profile_phase_name(i), profile->phase_ns[i] * 1e-9,
+			phase_sum > 0 ? 100.0 * profile->phase_ns[i] / phase_sum : 0.0, profile->phase_calls[i],
+			profile->phase_calls[i] > 0 ? (double)profile->phase_ns[i] / profile->phase_calls[i] : 0.0);
+	}
+	fprintf(file, "\tevaluations: %lld, %.6e per second\n", profile->evaluations, seconds > 0.0 ? profile->evaluations / seconds : 0.0);
+	fprintf(file, "\tavoided evaluations: %lld\n", profile->avoided);
+	fprintf(file, "\tlocal search moves: %lld, %.6e per second\n", profile->ls_moves,
+		profile->phase_ns[PHASE_LOCAL_SEARCH] > 0 ? profile->ls_moves / (profile->phase_ns[PHASE_LOCAL_SEARCH] * 1e-9) : 0.0);
+}
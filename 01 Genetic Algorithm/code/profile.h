@@ -0,0 +1,88 @@
+#ifndef _HEADER_PROFILE_H
+#define _HEADER_PROFILE_H	1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+/*
+** 1 compiles the phase timers and counters into the GA, 0 compiles them away: the PROFILE_ macros expand
+** to nothing and profiles stay zero. it can be set on the command line, for example -DGA_PROFILE=1.
+*/
+#ifndef GA_PROFILE
+#define GA_PROFILE	0
+#endif
+
+/*phases of a generation*/
+#define PHASE_SELECTION	0
+#define PHASE_CROSSOVER	1
+#define PHASE_MUTATION	2
+#define PHASE_EVALUATION	3
+#define PHASE_SCALING	4
+#define PHASE_ELITE	5	/*keeping the elite and selecting the best chromosome*/
+#define PHASE_LOCAL_SEARCH	6	/*hybrid local search*/
+#define PHASE_NUMBER	7
+
+/*
+** time and counters of the phases of one or more runs. phases which run on several threads add up
+** the time of all threads, so with a pool they can sum to more than total_ns.
+*/
+typedef struct Profile {
+	long long phase_ns[PHASE_NUMBER];	/*nanoseconds spent in each phase*/
+	long long phase_calls[PHASE_NUMBER];	/*number of times each phase was timed*/
+	long long total_ns;	/*wall time of the runs*/
+	long long runs;	/*number of runs*/
+	long long generations;	/*number of generations*/
+	long long evaluations;	/*evaluations of the object function, including the local search*/
+	long long avoided;	/*evaluations skipped because the child is equal to a parent*/
+	long long ls_moves;	/*moves tried by the local search*/
+} Profile;
+
+/*monotonic time in nanoseconds*/
+static inline long long profile_now(void)
+{
+	return (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*add the time since *mark to phase of profile and move *mark to now*/
+static inline void profile_lap(Profile *profile, int phase, long long *mark)
+{
+	long long now = profile_now();
+
+	profile->phase_ns[phase] += now - *mark;
+	profile->phase_calls[phase] += 1;
+	*mark = now;
+}
+
+/*
+** instrumentation of the hot paths, nothing is left of it if GA_PROFILE is 0.
+**	PROFILE_MARK(mark)	declare a time mark and set it to now
+**	PROFILE_LAP(p, phase, mark)	add the time since mark to phase of profile p (may be NULL) and restart mark
+**	PROFILE_COUNT(p, field, n)	add n to counter field of profile p (may be NULL)
+*/
+#if GA_PROFILE
+#define PROFILE_MARK(mark)	long long mark = profile_now()
+#define PROFILE_LAP(p, phase, mark)	do { if ((p) != NULL) profile_lap((p), (phase), &(mark)); } while (0)
+#define PROFILE_COUNT(p, field, n)	do { if ((p) != NULL) (p)->field += (n); } while (0)
+#else
+#define PROFILE_MARK(mark)
+#define PROFILE_LAP(p, phase, mark)	((void)(p))
+#define PROFILE_COUNT(p, field, n)	((void)(p))
+#endif
+
+/*set all times and counters of a profile to 0*/
+void profile_clear(Profile *profile);
+
+/*add the times and counters of src to dst*/
+void profile_merge(Profile *dst, Profile const *src);
+
+/*name of a phase*/
+char const *profile_phase_name(int phase);
+
+/*print a profile as a table of phases followed by the rates, title names what it belongs to*/
+void profile_print(FILE *file, Profile const *profile, char const *title);
+
+#endif
@@ -0,0 +1,368 @@
+#include "results.h"
+#include "bitpack.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#define WRITE_BUFFER_SIZE	(1 << 20)	/*stdio buffer of the results files, a batch is written with few system calls*/
+#define FILE_NAME_SIZE	300	/*longest file name of a sink file*/
+
+/*a finished run waiting for the writer*/
+typedef struct Sink_Entry {
+	int d_index;
+	float d;
+	int run;
+	Result *result;
+} Sink_Entry;
+
+struct result_sink {
+	FILE *bin_file;
+	FILE *csv_file;	/*NULL if no csv summary is written*/
+	char bin_name[FILE_NAME_SIZE];
+	char csv_name[FILE_NAME_SIZE];
+	char const *failed_name;	/*file of the first write which failed, NULL if none did. it is set by the writer and read after it stopped*/
+	std::thread writer;
+	std::mutex lock;
+	std::condition_variable not_empty;	/*signaled when a run is queued or the sink closes*/
+	std::condition_variable not_full;	/*signaled when the writer takes the queue*/
+	std::deque<Sink_Entry> queue;
+	size_t capacity;
+	bool closing;
+};
+
+/*write the binary record of one run, return 0 if a write failed*/
+static int write_record(FILE *file, Sink_Entry const *entry, unsigned char *packed)
+{
+	Result const *result = entry->result;
+	int32_t ints[5] = { entry->d_index, entry->run, result->success, result->loop_times, result->node_number };
+	int64_t seconds[2] = { result->start_seconds, result->end_seconds };
+	int32_t trace_len = result->trace_len;
+	size_t packed_size = (result->node_number + 3) / 4;
+	uint32_t size = (uint32_t)(sizeof ints + sizeof entry->d + sizeof result->eval_times + sizeof result->avoided_times + sizeof seconds + sizeof trace_len
+		+ trace_len * (sizeof(int32_t) + 2 * sizeof(double)) + packed_size);
+	int written = 1;
+
+	pack_genes(result->solution, result->node_number, packed);
+
+	written &= fwrite(&size, sizeof size, 1, file) == 1;
+	written &= fwrite(ints, sizeof ints, 1, file) == 1;
+	written &= fwrite(&entry->d, sizeof entry->d, 1, file) == 1;
+	written &= fwrite(&result->eval_times, sizeof result->eval_times, 1, file) == 1;
+	written &= fwrite(&result->avoided_times, sizeof result->avoided_times, 1, file) == 1;
+	written &= fwrite(seconds, sizeof seconds, 1, file) == 1;
+	written &= fwrite(&trace_len, sizeof trace_len, 1, file) == 1;
+	for (int i = 0; i < trace_len; i++) {
+		int32_t generation = result->trace[i].generation;
+
+		/*field by field, the padding of Trace_Point is not stored*/
+		written &= fwrite(&generation, sizeof generation, 1, file) == 1;
+		written &= fwrite(&result->trace[i].eval_times, sizeof(double), 1, file) == 1;
+		written &= fwrite(&result->trace[i].fitness, sizeof(double), 1, file) == 1;
+	}
+	written &= fwrite(packed, 1, packed_size, file) == packed_size;
+
+	return written;
+}
+
+/*remember the first file a write failed on, result_sink_close reports it*/
+static void write_failed(Result_Sink *sink, char const *name)
+{
+	if (sink->failed_name == NULL) {
+		sink->failed_name = name;
+	}
+}
+
+/*main loop of the writer thread, it takes the whole queue at once and writes it as one batch*/
+static void writer_main(Result_Sink *sink)
+{
+	std::deque<Sink_Entry> batch;
+	unsigned char *packed = NULL;
+	size_t packed_capacity = 0;
+
+	while (1) {
+		{
+			std::unique_lock<std::mutex> guard(sink->lock);
+			sink->not_empty.wait(guard, [sink] { return !sink->queue.empty() || sink->closing; });
+			if (sink->queue.empty()) {
+				break;	/*closing and nothing left*/
+			}
+			batch.swap(sink->queue);
+		}
+		sink->not_full.notify_all();
+
+		for (size_t k = 0; k < batch.size(); k++) {
+			Sink_Entry const *entry = &batch[k];
+			size_t packed_size = (entry->result->node_number + 3) / 4;
+
+			if (packed_size > packed_capacity) {
+				free(packed);
+				if ((packed = (unsigned char *)malloc(packed_size)) == NULL) {
+					printf("[RESULTS.cpp--writer_main--ERROR] cannot allocate memory\n");
+					exit(EXIT_FAILURE);
+				}
+				packed_capacity = packed_size;
+			}
+
+			/*
+			** after a failed write the runs are still taken from the queue and released, so the campaign goes on.
+			*/
+			if (sink->failed_name == NULL && !write_record(sink->bin_file, entry, packed)) {
+				write_failed(sink, sink->bin_name);
+			}
+			if (sink->failed_name == NULL && sink->csv_file != NULL &&
+				fprintf(sink->csv_file, "%f, %d, %d, %d, %.6e, %.6e, %lld\n", entry->d, entry->run, entry->result->success,
+					entry->result->loop_times, entry->result->eval_times, entry->result->avoided_times,
+					entry->result->end_seconds - entry->result->start_seconds) < 0) {
+				write_failed(sink, sink->csv_name);
+			}
+			free(entry->result);
+		}
+		batch.clear();
+
+		/*
+		** a batch is flushed as a whole, so a crashed campaign loses at most the runs of one batch.
+		*/
+		if (fflush(sink->bin_file) != 0) {
+			write_failed(sink, sink->bin_name);
+		}
+		if (sink->csv_file != NULL && fflush(sink->csv_file) != 0) {
+			write_failed(sink, sink->csv_name);
+		}
+	}
+
+	free(packed);
+}
+
+/*open a file for the sink with a large stdio buffer, its name is put in file_name*/
+static FILE *open_sink_file(char const *path, char const *extension, char const *mode, char *file_name)
+{
+	FILE *file = NULL;
+
+	snprintf(file_name, FILE_NAME_SIZE, "%s%s", path, extension);
+	if ((file = fopen(file_name, mode)) == NULL) {
+		printf("[RESULTS.cpp--result_sink_open--ERROR] cannot open %s\n", file_name);
+		exit(EXIT_FAILURE);
+	}
+	setvbuf(file, NULL, _IOFBF, WRITE_BUFFER_SIZE);
+
+	return file;
+}
+
+/*
+** open a results sink. records go to path + ".bin", and if csv is not 0, a summary line of each run goes to path + ".csv".
+** queue_capacity finished runs can wait for the writer thread, <= 0 means RESULTS_QUEUE.
+*/
+Result_Sink *result_sink_open(char const *path, int csv, int queue_capacity)
+{
+	Result_Sink *sink = new Result_Sink;
+	int32_t version = RESULTS_VERSION;
+
+	sink->bin_file = open_sink_file(path, ".bin", "wb", sink->bin_name);
+	sink->csv_file = csv ? open_sink_file(path, ".csv", "w", sink->csv_name) : NULL;
+	sink->capacity = queue_capacity > 0 ? queue_capacity : RESULTS_QUEUE;
+	sink->closing = false;
+	sink->failed_name = NULL;
+
+	if (fwrite(RESULTS_MAGIC, 1, 4, sink->bin_file) != 4 || fwrite(&version, sizeof version, 1, sink->bin_file) != 1) {
+		write_failed(sink, sink->bin_name);
+	}
+	if (sink->csv_file != NULL && fprintf(sink->csv_file, "d, run, success, loop times, evaluation times, avoided evaluations, seconds\n") < 0) {
+		write_failed(sink, sink->csv_name);
+	}
+
+	sink->writer = std::thread(writer_main, sink);
+
+	return sink;
+}
+
+/*queue a finished run. the sink owns result from now on and frees it once written. it only waits if the queue is full*/
+void result_sink_put(Result_Sink *sink, int d_index, float d, int run, Result *result)
+{
+	Sink_Entry entry = { d_index, d, run, result };
+
+	{
+		std::unique_lock<std::mutex> guard(sink->lock);
+		sink->not_full.wait(guard, [sink] { return sink->queue.size() < sink->capacity; });
+		sink->queue.push_back(entry);
+	}
+	sink->not_empty.notify_one();
+}
+
+/*write all queued runs, stop the writer thread and close the files. if a write failed, the program stops with the file it failed on*/
+void result_sink_close(Result_Sink *sink)
+{
+	{
+		std::lock_guard<std::mutex> guard(sink->lock);
+		sink->closing = true;
+	}
+	sink->not_empty.notify_one();
+	sink->writer.join();
+
+	if (fclose(sink->bin_file) != 0) {
+		write_failed(sink, sink->bin_name);
+	}
+	if (sink->csv_file != NULL && fclose(sink->csv_file) != 0) {
+		write_failed(sink, sink->csv_name);
+	}
+	if (sink->failed_name != NULL) {
+		printf("[RESULTS.cpp--result_sink_close--ERROR] cannot write %s, its results are incomplete\n", sink->failed_name);
+		exit(EXIT_FAILURE);
+	}
+	delete sink;
+}
+
+/*check the header of a binary results file, return 0 if it is not one*/
+int read_results_header(FILE *file)
+{
+	char magic[4];
+	int32_t version = 0;
+
+	if (fread(magic, 1, 4, file) != 4 || memcmp(magic, RESULTS_MAGIC, 4) != 0) {
+		return 0;
+	}
+	if (fread(&version, sizeof version, 1, file) != 1 || version != RESULTS_VERSION) {
+		return 0;
+	}
+
+	return 1;
+}
+
+/*
+** read the next record of a binary results file, the caller frees the result. NULL at the end of the file, and also
+** if the record is broken or truncated, then *broken is set to 1. it is set to 0 otherwise.
+*/
+Result *read_result_record(FILE *file, int *d_index, float *d, int *run, int *broken)
+{
+	uint32_t size = 0;
+	size_t size_read = 0;
+	int32_t ints[5];
+	int64_t seconds[2];
+	int32_t trace_len = 0;
+	int points = 0;
+	float d_value = 0.0f;
+	double eval_times = 0.0;
+	double avoided_times = 0.0;
+	Result *result = NULL;
+	unsigned char *packed = NULL;
+	time_t start_time;
+	time_t end_time;
+
+	*broken = 1;
+	if ((size_read = fread(&size, 1, sizeof size, file)) == 0 && feof(file) && !ferror(file)) {
+		*broken = 0;	/*the end of the file between two records*/
+		return NULL;
+	}
+	if (size_read != sizeof size || fread(ints, sizeof ints, 1, file) != 1) {
+		printf("[RESULTS.cpp--read_result_record--ERROR] truncated record\n");
+		return NULL;
+	}
+	if (fread(&d_value, sizeof d_value, 1, file) != 1 || fread(&eval_times, sizeof eval_times, 1, file) != 1 ||
+		fread(&avoided_times, sizeof avoided_times, 1, file) != 1 || fread(seconds, sizeof seconds, 1, file) != 1 ||
+		fread(&trace_len, sizeof trace_len, 1, file) != 1) {
+		printf("[RESULTS.cpp--read_result_record--ERROR] truncated record\n");
+		return NULL;
+	}
+	/*
+	** the trace and the node number must add up to the size of the record before anything is allocated for them.
+	*/
+	if (ints[3] < 0 || ints[4] <= 0 || trace_len < 0 || (uint64_t)trace_len > size / (sizeof(int32_t) + 2 * sizeof(double)) ||
+		(uint64_t)size != sizeof ints + sizeof d_value + sizeof eval_times + sizeof avoided_times + sizeof seconds + sizeof trace_len
+			+ (uint64_t)trace_len * (sizeof(int32_t) + 2 * sizeof(double)) + ((uint64_t)ints[4] + 3) / 4) {
+		printf("[RESULTS.cpp--read_result_record--ERROR] broken record\n");
+		return NULL;
+	}
+
+	result = result_create(ints[4], trace_len);
+	packed = (unsigned char *)malloc((ints[4] + 3) / 4);
+	if (packed == NULL) {
+		printf("[RESULTS.cpp--read_result_record--ERROR] cannot allocate memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	*d_index = ints[0];
+	*run = ints[1];
+	result->success = ints[2];
+	result->loop_times = ints[3];
+	result->eval_times = eval_times;
+	result->avoided_times = avoided_times;
+	*d = d_value;
+	for (points = 0; points < trace_len; points++) {
+		int32_t generation = 0;
+
+		if (fread(&generation, sizeof generation, 1, file) != 1 ||
+			fread(&result->trace[points].eval_times, sizeof(double), 1, file) != 1 ||
+			fread(&result->trace[points].fitness, sizeof(double), 1, file) != 1) {
+			break;
+		}
+		result->trace[points].generation = generation;
+	}
+	if (points < trace_len || fread(packed, 1, (ints[4] + 3) / 4, file) != (size_t)(ints[4] + 3) / 4) {
+		printf("[RESULTS.cpp--read_result_record--ERROR] truncated record\n");
+		free(packed);
+		free(result);
+		return NULL;
+	}
+	unpack_genes(packed, result->node_number, result->solution);
+	free(packed);
+
+	/*
+	** the time strings are not stored, they are made again from the seconds.
+	*/
+	result->start_seconds = seconds[0];
+	result->end_seconds = seconds[1];
+	start_time = (time_t)seconds[0];
+	end_time = (time_t)seconds[1];
+	time_to_string(&start_time, result->start_time, sizeof result->start_time);
+	time_to_string(&end_time, result->end_time, sizeof result->end_time);
+	elapsed_times(&start_time, &end_time, result->s_elapsed_times);
+	*broken = 0;
+
+	return result;
+}
+
+/*export a binary results file to csv, one line per point of the convergence trace of each run. return EXIT_FAILURE if a record is broken or the csv cannot be written*/
+int export_results_csv(char const *bin_path, char const *csv_path)
+{
+	FILE *bin_file = NULL;
+	FILE *csv_file = NULL;
+	Result *result = NULL;
+	int d_index = 0;
+	float d = 0.0f;
+	int run = 0;
+	int broken = 0;
+	int written = 0;
+
+	if ((bin_file = fopen(bin_path, "rb")) == NULL || !read_results_header(bin_file)) {
+		printf("[RESULTS.cpp--export_results_csv--ERROR] cannot read %s\n", bin_path);
+		exit(EXIT_FAILURE);
+	}
+	if ((csv_file = fopen(csv_path, "w")) == NULL) {
+		printf("[RESULTS.cpp--export_results_csv--ERROR] cannot open %s\n", csv_path);
+		exit(EXIT_FAILURE);
+	}
+	setvbuf(csv_file, NULL, _IOFBF, WRITE_BUFFER_SIZE);
+
+	fprintf(csv_file, "d, run, generation, evaluation times, best fitness\n");
+	while ((result = read_result_record(bin_file, &d_index, &d, &run, &broken)) != NULL) {
+		for (int i = 0; i < result->trace_len; i++) {
+			fprintf(csv_file, "%f, %d, %8d, %.6e, %.8f\n", d, run, result->trace[i].generation, result->trace[i].eval_times, result->trace[i].fitness);
+		}
+		free(result);
+	}
+
+	fclose(bin_file);
+	written = !ferror(csv_file);
+	written &= fclose(csv_file) == 0;
+
+	if (broken) {
+		printf("[RESULTS.cpp--export_results_csv--ERROR] %s has a broken record, %s is incomplete\n", bin_path, csv_path);
+		return EXIT_FAILURE;
+	}
+	if (!written) {
+		printf("[RESULTS.cpp--export_results_csv--ERROR] cannot write %s\n", csv_path);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
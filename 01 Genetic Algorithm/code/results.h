@@ -0,0 +1,55 @@
+#ifndef _HEADER_RESULTS_H
+#define _HEADER_RESULTS_H	1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "geneticalgorithm.h"
+
+#define RESULTS_MAGIC	"GARS"	/*first 4 bytes of a binary results file*/
+#define RESULTS_VERSION	3	/*version of the record layout below*/
+#define RESULTS_QUEUE	64	/*default number of finished runs which can wait for the writer thread*/
+
+/*
+** binary results file: RESULTS_MAGIC, int32 RESULTS_VERSION, then one record per run in native byte order.
+** a record is:
+**	uint32	size of the rest of the record in bytes
+**	int32	d index, run, success, loop times, node number
+**	float	d
+**	double	evaluation times, avoided evaluations
+**	int64	start seconds, end seconds
+**	int32	trace length
+**	trace length points of the convergence trace, each an int32 generation, a double evaluation times and a double fitness
+**	uint8	best solution, 2 bits per gene (see pack_genes)
+*/
+
+/*a results sink, finished runs are written by a background thread*/
+typedef struct result_sink Result_Sink;
+
+/*
+** open a results sink. records go to path + ".bin", and if csv is not 0, a summary line of each run goes to path + ".csv".
+** queue_capacity finished runs can wait for the writer thread, <= 0 means RESULTS_QUEUE.
+*/
+Result_Sink *result_sink_open(char const *path, int csv, int queue_capacity);
+
+/*queue a finished run. the sink owns result from now on and frees it once written. it only waits if the queue is full*/
+void result_sink_put(Result_Sink *sink, int d_index, float d, int run, Result *result);
+
+/*write all queued runs, stop the writer thread and close the files. if a write failed, the program stops with the file it failed on*/
+void result_sink_close(Result_Sink *sink);
+
+/*check the header of a binary results file, return 0 if it is not one*/
+int read_results_header(FILE *file);
+
+/*
+** read the next record of a binary results file, the caller frees the result. NULL at the end of the file, and also
+** if the record is broken or truncated, then *broken is set to 1. it is set to 0 otherwise.
+*/
+Result *read_result_record(FILE *file, int *d_index, float *d, int *run, int *broken);
+
+/*export a binary results file to csv, one line per point of the convergence trace of each run. return EXIT_FAILURE if a record is broken or the csv cannot be written*/
+int export_results_csv(char const *bin_path, char const *csv_path);
+
+#endif
@@ -0,0 +1,145 @@
+#include "rng.h"
+
+/*next output of splitmix64, it is used to expand a seed into a full state*/
+static uint64_t splitmix64(uint64_t *x)
+{
+	uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/*seed a generator of kind, the 4 words of xoshiro256** state are expanded from seed by splitmix64*/
+void rng_seed(Rng *rng, int kind, uint64_t seed)
+{
+	rng->kind = kind;
+
+	switch (kind)
+	{
+	case RNG_XOSHIRO:
+		for (int i = 0; i < 4; i++) {
+			rng->s[i] = splitmix64(&seed);
+		}
+		break;
+
+	case RNG_MT:
+	{
+		unsigned long key[2] = { (unsigned long)(seed & 0xffffffffUL), (unsigned long)(seed >> 32) };
+		init_by_array(&rng->mt, key, 2);
+		break;
+	}
+
+	default:
+		printf("[RNG.cpp--rng_seed--ERROR] no such generator\n");
+		exit(EXIT_FAILURE);
+		break;
+	}
+}
+
+/*advance the generator as if 2^128 numbers were drawn. for Mersenne Twister it is reseeded from its own output*/
+void rng_jump(Rng *rng)
+{
+	static uint64_t const jump[4] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+
+	if (rng->kind == RNG_MT) {
+		/*
+		** MT19937 has no cheap jump polynomial, a new state is derived from 4 outputs instead.
+		*/
+		unsigned long key[4];
+		for (int i = 0; i < 4; i++) {
+			key[i] = genrand_int32(&rng->mt);
+		}
+		init_by_array(&rng->mt, key, 4);
+		return;
+	}
+
+	uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	for (int i = 0; i < 4; i++) {
+		for (int b = 0; b < 64; b++) {
+			if (jump[i] & (1ULL << b)) {
+				s0 ^= rng->s[0];
+				s1 ^= rng->s[1];
+				s2 ^= rng->s[2];
+				s3 ^= rng->s[3];
+			}
+			rng_u64(rng);
+		}
+	}
+	rng->s[0] = s0;
+	rng->s[1] = s1;
+	rng->s[2] = s2;
+	rng->s[3] = s3;
+}
+
+/*give child the current stream of rng, then jump rng past it. children split one after another never overlap*/
+void rng_split(Rng *rng, Rng *child)
+{
+	if (rng->kind == RNG_MT) {
+		/*the child is the reseeded generator, the parent keeps drawing from its own state*/
+		*child = *rng;
+		rng_jump(child);
+		genrand_int32(&rng->mt);
+		return;
+	}
+
+	*child = *rng;
+	rng_jump(rng);
+}
+
+/*seed child of the same kind from one draw of rng. it is much cheaper than rng_split, for short-lived streams*/
+void rng_derive(Rng *rng, Rng *child)
+{
+	rng_seed(child, rng->kind, rng_u64(rng));
+}
+
+/*Mersenne Twister step, see rng_u64*/
+uint64_t rng_mt_u64(Rng *rng)
+{
+	uint64_t high = genrand_int32(&rng->mt);
+	return (high << 32) | genrand_int32(&rng->mt);
+}
+
+/*fill buffer with count integers in [0, bound), each 64-bit draw gives two of them. bound must fit in a char*/
+void rng_fill_below(Rng *rng, char *buffer, int count, int bound)
+{
+	int i = 0;
+
+	while (i < count) {
+		uint64_t x = rng_u64(rng);
+		uint32_t value;
+
+		if (rng_map_below((uint32_t)(x >> 32), (uint32_t)bound, &value)) {
+			buffer[i++] = (char)value;
+		}
+		if (i < count && rng_map_below((uint32_t)x, (uint32_t)bound, &value)) {
+			buffer[i++] = (char)value;
+		}
+	}
+}
+
+/*fill buffer with count integers in [0, bound)*/
+void rng_fill_int(Rng *rng, int *buffer, int count, int bound)
+{
+	int i = 0;
+
+	while (i < count) {
+		uint64_t x = rng_u64(rng);
+		uint32_t value;
+
+		if (rng_map_below((uint32_t)(x >> 32), (uint32_t)bound, &value)) {
+			buffer[i++] = (int)value;
+		}
+		if (i < count && rng_map_below((uint32_t)x, (uint32_t)bound, &value)) {
+			buffer[i++] = (int)value;
+		}
+	}
+}
+
+/*fill buffer with count double random numbers in [0, 1)*/
+void rng_fill_double(Rng *rng, double *buffer, int count)
+{
+	for (int i = 0; i < count; i++) {
+		buffer[i] = rng_double(rng);
+	}
+}
@@ -0,0 +1,117 @@
+#ifndef _HEADER_RNG_H
+#define _HEADER_RNG_H	1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "mt.h"
+
+#define RNG_XOSHIRO	1	/*xoshiro256**, period 2^256 - 1, streams are split by jump-ahead*/
+#define RNG_MT	2	/*Mersenne Twister MT19937, streams are split by reseeding from the parent's output*/
+#define RNG_DEFAULT	RNG_XOSHIRO	/*generator used when none is chosen*/
+
+/*
+** a random number generator. every solver owns one and passes it down, so nothing is shared between
+** threads and the numbers a run draws depend only on its own seed.
+*/
+typedef struct rng {
+	int kind;	/*RNG_XOSHIRO or RNG_MT*/
+	uint64_t s[4];	/*xoshiro256** state*/
+	Mt_State mt;	/*Mersenne Twister state*/
+} Rng;
+
+/*seed a generator of kind, the 4 words of xoshiro256** state are expanded from seed by splitmix64*/
+void rng_seed(Rng *rng, int kind, uint64_t seed);
+
+/*advance the generator as if 2^128 numbers were drawn. for Mersenne Twister it is reseeded from its own output*/
+void rng_jump(Rng *rng);
+
+/*give child the current stream of rng, then jump rng past it. children split one after another never overlap*/
+void rng_split(Rng *rng, Rng *child);
+
+/*seed child of the same kind from one draw of rng. it is much cheaper than rng_split, for short-lived streams*/
+void rng_derive(Rng *rng, Rng *child);
+
+/*Mersenne Twister step, see rng_u64*/
+uint64_t rng_mt_u64(Rng *rng);
+
+/*generate a random 64-bit integer. it is inlined because it sits in every gene loop*/
+static inline uint64_t rng_u64(Rng *rng)
+{
+	if (rng->kind != RNG_XOSHIRO) {
+		return rng_mt_u64(rng);
+	}
+
+	uint64_t *s = rng->s;
+	uint64_t x = s[1] * 5;
+	uint64_t result = ((x << 7) | (x >> 57)) * 9;
+	uint64_t t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = (s[3] << 45) | (s[3] >> 19);
+
+	return result;
+}
+
+/*generate a random 32-bit integer*/
+static inline uint32_t rng_u32(Rng *rng)
+{
+	return (uint32_t)(rng_u64(rng) >> 32);
+}
+
+/*generate a double random number in [0, 1) with 53-bit resolution*/
+static inline double rng_double(Rng *rng)
+{
+	return (rng_u64(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*map a 32-bit random number x to [0, bound) without division (Lemire). 0 is returned if x must be rejected*/
+static inline int rng_map_below(uint32_t x, uint32_t bound, uint32_t *value)
+{
+	uint64_t m = (uint64_t)x * bound;
+
+	*value = (uint32_t)(m >> 32);
+	if ((uint32_t)m < bound) {
+		/*the low part falls in the biased zone only if it is below 2^32 mod bound*/
+		return (uint32_t)m >= (uint32_t)(-bound) % bound;
+	}
+	return 1;
+}
+
+/*generate an unbiased integer random number in [0, bound), bound > 0*/
+static inline int rng_below(Rng *rng, int bound)
+{
+	uint32_t value;
+
+	while (!rng_map_below(rng_u32(rng), (uint32_t)bound, &value))
+		;
+	return (int)value;
+}
+
+/*generate an unbiased 64-bit integer random number in [0, bound), bound > 0. it divides, so rng_below is faster for small bounds*/
+static inline uint64_t rng_below64(Rng *rng, uint64_t bound)
+{
+	uint64_t threshold = (0 - bound) % bound;	/*2^64 mod bound, draws below it are rejected*/
+	uint64_t x;
+
+	do {
+		x = rng_u64(rng);
+	} while (x < threshold);
+	return x % bound;
+}
+
+/*fill buffer with count integers in [0, bound), each 64-bit draw gives two of them. bound must fit in a char*/
+void rng_fill_below(Rng *rng, char *buffer, int count, int bound);
+
+/*fill buffer with count integers in [0, bound)*/
+void rng_fill_int(Rng *rng, int *buffer, int count, int bound);
+
+/*fill buffer with count double random numbers in [0, 1)*/
+void rng_fill_double(Rng *rng, double *buffer, int count);
+
+#endif
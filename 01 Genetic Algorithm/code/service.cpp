@@ -0,0 +1,464 @@
+#include "service.h"
+#include "bitpack.h"
+
+#include <ctype.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#define JOB_HEADER_SIZE	28	/*bytes of a job frame before its settings: job id, 3 int32, seed and the length of the settings*/
+#define SERVICE_MAX_GENES	(1 << 28)	/*largest node number x population size of a job*/
+#define MESSAGE_SIZE	300	/*longest error message of a reply*/
+
+/*a job frame read from the input. the frames are kept on a free list, so their buffers are reused by the next jobs*/
+typedef struct Service_Job {
+	struct solver_service *service;
+	unsigned char *frame;	/*the frame after its size*/
+	size_t capacity;	/*number of bytes frame can hold*/
+	uint32_t size;	/*number of bytes of the frame*/
+} Service_Job;
+
+/*what a worker keeps from one job to the next, all buffers only grow*/
+typedef struct Service_Worker {
+	Graph graph;	/*graph of the current job*/
+	GA_Run run;	/*populations and workspaces of the current job*/
+	int *links;	/*aligned copy of the links of the frame*/
+	size_t link_capacity;
+	int *marks;	/*workspace of check_repeated_links*/
+	size_t mark_capacity;
+	char *settings;	/*settings of the frame with a terminating 0*/
+	size_t settings_capacity;
+	unsigned char *packed;	/*best solution of the reply, 2 bits per gene*/
+	size_t packed_capacity;
+	char message[MESSAGE_SIZE];	/*error message of the reply*/
+} Service_Worker;
+
+struct solver_service {
+	GA_Config config;	/*base of the settings of every job*/
+	Thread_Pool *pool;
+	int worker_number;
+	Service_Worker *workers;	/*one per worker of pool*/
+	int job_number;	/*number of frames which can be read ahead*/
+	Service_Job *jobs;
+	std::vector<Service_Job *> free_jobs;
+	std::mutex lock;	/*protects free_jobs*/
+	std::condition_variable job_freed;	/*signaled when a job goes back to free_jobs*/
+	FILE *out;	/*replies of the current connection*/
+	std::mutex out_lock;	/*a reply frame is written as a whole*/
+};
+
+/*make *buffer hold at least bytes, its contents are not kept*/
+static void reserve_buffer(void **buffer, size_t *capacity, size_t bytes)
+{
+	if (bytes <= *capacity) {
+		return;
+	}
+	free(*buffer);
+	if ((*buffer = malloc(bytes)) == NULL) {
+		printf("[SERVICE.cpp--reserve_buffer--ERROR] cannot allocate memory\n");
+		exit(EXIT_FAILURE);
+	}
+	*capacity = bytes;
+}
+
+/*take a free job frame, wait until a worker gives one back if there is none*/
+static Service_Job *take_job(Solver_Service *service)
+{
+	std::unique_lock<std::mutex> guard(service->lock);
+	Service_Job *job = NULL;
+
+	service->job_freed.wait(guard, [service] { return !service->free_jobs.empty(); });
+	job = service->free_jobs.back();
+	service->free_jobs.pop_back();
+
+	return job;
+}
+
+/*give a job frame back to the free list*/
+static void give_job(Solver_Service *service, Service_Job *job)
+{
+	{
+		std::lock_guard<std::mutex> guard(service->lock);
+		service->free_jobs.push_back(job);
+	}
+	service->job_freed.notify_one();
+}
+
+/*read the next job frame of in. return 1 if it was read, 0 at the end of in, -1 if the stream is broken*/
+static int read_frame(FILE *in, Service_Job *job)
+{
+	uint32_t size = 0;
+
+	if (fread(&size, sizeof size, 1, in) != 1) {
+		return 0;
+	}
+	if (size < sizeof(uint32_t) || size > SERVICE_MAX_FRAME) {
+		return -1;
+	}
+	reserve_buffer((void **)&job->frame, &job->capacity, size);
+	if (fread(job->frame, 1, size, in) != size) {
+		return -1;
+	}
+	job->size = size;
+
+	return 1;
+}
+
+/*write an error reply*/
+static void write_error(Solver_Service *service, uint32_t id, int status, char const *message)
+{
+	int32_t status_code = status;
+	uint32_t size = (uint32_t)(sizeof id + sizeof status_code + strlen(message));
+	std::lock_guard<std::mutex> guard(service->out_lock);
+
+	fwrite(&size, sizeof size, 1, service->out);
+	fwrite(&id, sizeof id, 1, service->out);
+	fwrite(&status_code, sizeof status_code, 1, service->out);
+	fwrite(message, 1, strlen(message), service->out);
+	fflush(service->out);
+}
+
+/*write the reply of a job solved by the run of worker, straight from the run*/
+static void write_result(Solver_Service *service, Service_Worker *worker, uint32_t id, long long ns)
+{
+	GA_Run const *run = &worker->run;
+	int node_number = worker->graph.node_number;
+	char const *solution = run->parents->chromos[run->parent_best].solution;
+	int32_t status_code = SERVICE_OK;
+	int32_t ints[3] = { run->gbest == 1.0, run->count, node_number };
+	int64_t job_ns = ns;
+	int32_t trace_len = run->trace.len;
+	size_t packed_size = (node_number + 3) / 4;
+	uint32_t size = (uint32_t)(sizeof id + sizeof status_code + sizeof ints + sizeof run->eval_times + sizeof run->avoided_times
+		+ sizeof job_ns + sizeof trace_len + trace_len * (sizeof(int32_t) + 2 * sizeof(double)) + packed_size);
+
+	reserve_buffer((void **)&worker->packed, &worker->packed_capacity, packed_size);
+	pack_genes(solution, node_number, worker->packed);
+
+	std::lock_guard<std::mutex> guard(service->out_lock);
+	fwrite(&size, sizeof size, 1, service->out);
+	fwrite(&id, sizeof id, 1, service->out);
+	fwrite(&status_code, sizeof status_code, 1, service->out);
+	fwrite(ints, sizeof ints, 1, service->out);
+	fwrite(&run->eval_times, sizeof run->eval_times, 1, service->out);
+	fwrite(&run->avoided_times, sizeof run->avoided_times, 1, service->out);
+	fwrite(&job_ns, sizeof job_ns, 1, service->out);
+	fwrite(&trace_len, sizeof trace_len, 1, service->out);
+	for (int i = 0; i < trace_len; i++) {
+		int32_t generation = run->trace.points[i].generation;
+
+		/*field by field like the results file, the padding of Trace_Point is not sent*/
+		fwrite(&generation, sizeof generation, 1, service->out);
+		fwrite(&run->trace.points[i].eval_times, sizeof(double), 1, service->out);
+		fwrite(&run->trace.points[i].fitness, sizeof(double), 1, service->out);
+	}
+	fwrite(worker->packed, 1, packed_size, service->out);
+	fflush(service->out);
+}
+
+/*apply the settings of a job, one per line, to config. return NULL or the message of the first bad one*/
+static char const *apply_settings(Service_Worker *worker, GA_Config *config, char const *settings, int length)
+{
+	char *line = NULL;
+	char const *error = NULL;
+
+	reserve_buffer((void **)&worker->settings, &worker->settings_capacity, length + 1);
+	memcpy(worker->settings, settings, length);
+	worker->settings[length] = '\0';
+
+	for (line = worker->settings; line != NULL && error == NULL; ) {
+		char *next = strchr(line, '\n');
+		char *comment = NULL;
+		char const *p = line;
+
+		if (next != NULL) {
+			*next++ = '\0';
+		}
+		if ((comment = strchr(line, '#')) != NULL) {
+			*comment = '\0';
+		}
+		while (isspace((unsigned char)*p)) {
+			p++;
+		}
+		if (*p != '\0' && (error = ga_config_apply(config, line)) != NULL) {
+			snprintf(worker->message, sizeof worker->message, "%s: \"%s\"", error, line);
+			error = worker->message;
+		}
+		line = next;
+	}
+
+	return error;
+}
+
+/*
+** check a job frame and set up its config, population size, seed and the graph of worker.
+** return SERVICE_OK, or an error status with *message set.
+*/
+static int parse_job(Solver_Service const *service, Service_Worker *worker, Service_Job const *job,
+	GA_Config *config, int *pop_size, uint64_t *seed, char const **message)
+{
+	unsigned char const *frame = job->frame;
+	int32_t numbers[3];
+	int32_t settings_length = 0;
+	int node_number = 0;
+	int edge_number = 0;
+	size_t link_bytes = 0;
+
+	if (job->size < JOB_HEADER_SIZE) {
+		*message = "the frame is shorter than its header";
+		return SERVICE_BAD_FRAME;
+	}
+	memcpy(numbers, frame + 4, sizeof numbers);
+	memcpy(seed, frame + 16, sizeof *seed);
+	memcpy(&settings_length, frame + 24, sizeof settings_length);
+	node_number = numbers[0];
+	edge_number = numbers[1];
+	*pop_size = numbers[2] > 0 ? numbers[2] : DEFAULT_POP_SIZE;
+
+	if (settings_length < 0 || (size_t)settings_length > job->size - JOB_HEADER_SIZE) {
+		*message = "the settings do not fit in the frame";
+		return SERVICE_BAD_FRAME;
+	}
+	link_bytes = job->size - JOB_HEADER_SIZE - settings_length;
+	if (node_number < 2 || edge_number < 1 || link_bytes != 2 * (size_t)edge_number * sizeof(int32_t)) {
+		*message = "a graph needs 2 nodes and 1 link, and 2 x edge number ends must fill the rest of the frame";
+		return SERVICE_BAD_FRAME;
+	}
+
+	/*
+	** the config of the job is the one of the service with the settings of the job.
+	*/
+	*config = service->config;
+	if ((*message = apply_settings(worker, config, (char const *)frame + JOB_HEADER_SIZE, settings_length)) != NULL ||
+		(*message = ga_config_error(config)) != NULL) {
+		return SERVICE_BAD_CONFIG;
+	}
+	if (*pop_size % 2 != 0 || *pop_size <= config->k_candidate || (double)*pop_size * node_number > SERVICE_MAX_GENES) {
+		*message = "the population size must be even and larger than k_candidate, and not too large for the node number";
+		return SERVICE_BAD_CONFIG;
+	}
+
+	/*
+	** the links are copied out of the frame, they may not be aligned there.
+	*/
+	reserve_buffer((void **)&worker->links, &worker->link_capacity, link_bytes);
+	memcpy(worker->links, frame + JOB_HEADER_SIZE + settings_length, link_bytes);
+	if ((*message = check_links(node_number, edge_number, worker->links)) != NULL) {
+		return SERVICE_BAD_FRAME;
+	}
+	graph_build(&worker->graph, node_number, edge_number, worker->links);
+	reserve_buffer((void **)&worker->marks, &worker->mark_capacity, node_number * sizeof(int));
+	if ((*message = check_repeated_links(&worker->graph, worker->marks)) != NULL) {
+		return SERVICE_BAD_FRAME;
+	}
+
+	return SERVICE_OK;
+}
+
+/*solve one job on a worker and write its reply, then give the frame back*/
+static void service_job(void *arg, int worker_index)
+{
+	Service_Job *job = (Service_Job *)arg;
+	Solver_Service *service = job->service;
+	Service_Worker *worker = service->workers + worker_index;
+	long long start = profile_now();
+	uint32_t id = 0;
+	GA_Config config;
+	int pop_size = 0;
+	uint64_t seed = 0;
+	char const *message = NULL;
+	int status = SERVICE_OK;
+
+	memcpy(&id, job->frame, sizeof id);
+	status = parse_job(service, worker, job, &config, &pop_size, &seed, &message);
+	give_job(service, job);	/*everything the job needs is with the worker now*/
+
+	if (status != SERVICE_OK) {
+		write_error(service, id, status, message);
+		return;
+	}
+
+	Rng rng;
+	rng_seed(&rng, RNG_DEFAULT, seed);
+
+	/*
+	** the loop of ga_run_solve, but the reply is written from the run itself, so a job allocates no result record.
+	*/
+	ga_run_restart(&worker->run, &worker->graph, pop_size, &config, &rng, NULL);
+	while (worker->run.count < worker->run.config.max_loop && worker->run.gbest != 1.0) {
+		ga_run_step(&worker->run);
+	}
+	write_result(service, worker, id, profile_now() - start);
+}
+
+/*
+** create a service with thread_count workers, <= 0 means one per core. each worker keeps a graph and a GA run whose buffers
+** grow to the largest job it has solved, so a job allocates almost nothing. config is the base of the settings of every job,
+** NULL means the defaults.
+*/
+Solver_Service *service_create(int thread_count, GA_Config const *config)
+{
+	Solver_Service *service = new Solver_Service;
+
+	if (config != NULL) {
+		service->config = *config;
+	}
+	else {
+		ga_config_default(&service->config);
+	}
+	ga_config_check(&service->config);
+
+	service->pool = thread_pool_create(thread_count);
+	service->worker_number = thread_pool_size(service->pool);
+	service->workers = (Service_Worker *)calloc(service->worker_number, sizeof(Service_Worker));
+	service->job_number = SERVICE_JOBS_PER_WORKER * service->worker_number;
+	service->jobs = (Service_Job *)calloc(service->job_number, sizeof(Service_Job));
+	service->out = NULL;
+	if (service->workers == NULL || service->jobs == NULL) {
+		printf("[SERVICE.cpp--service_create--ERROR] cannot allocate memory\n");
+		exit(EXIT_FAILURE);
+	}
+	for (int i = 0; i < service->job_number; i++) {
+		service->jobs[i].service = service;
+		service->free_jobs.push_back(service->jobs + i);
+	}
+
+	return service;
+}
+
+/*serve the jobs of in until it ends, the replies go to out. return the number of jobs served*/
+long service_run(Solver_Service *service, FILE *in, FILE *out)
+{
+	int32_t version = SERVICE_VERSION;
+	long served = 0;
+
+	service->out = out;
+	fwrite(SERVICE_MAGIC, 1, 4, out);
+	fwrite(&version, sizeof version, 1, out);
+	fflush(out);
+
+	/*
+	** frames are read ahead while the workers solve the jobs before them, at most job_number of them.
+	*/
+	while (1) {
+		Service_Job *job = take_job(service);
+		int status = read_frame(in, job);
+
+		if (status <= 0) {
+			give_job(service, job);
+			thread_pool_wait(service->pool);
+			if (status < 0) {
+				write_error(service, 0, SERVICE_BAD_FRAME, "the stream is broken, no more jobs are read");
+			}
+			break;
+		}
+		thread_pool_submit(service->pool, service_job, job);
+		served += 1;
+	}
+
+	fflush(out);
+	service->out = NULL;
+
+	return served;
+}
+
+/*listen on a unix domain socket at path and serve its connections one after another. it only returns on an error*/
+int service_listen(Solver_Service *service, char const *path)
+{
+#ifdef _WIN32
+	(void)service;
+	printf("[SERVICE.cpp--service_listen--ERROR] unix domain sockets are not supported, cannot listen on %s\n", path);
+	return EXIT_FAILURE;
+#else
+	struct sockaddr_un address;
+	int listener = -1;
+
+	if (strlen(path) >= sizeof address.sun_path) {
+		printf("[SERVICE.cpp--service_listen--ERROR] socket path %s is too long\n", path);
+		return EXIT_FAILURE;
+	}
+	memset(&address, 0, sizeof address);
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+
+	signal(SIGPIPE, SIG_IGN);	/*a client which goes away must not end the service*/
+	unlink(path);
+	listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener < 0 || bind(listener, (struct sockaddr *)&address, sizeof address) != 0 || listen(listener, SOMAXCONN) != 0) {
+		printf("[SERVICE.cpp--service_listen--ERROR] cannot listen on %s\n", path);
+		if (listener >= 0) {
+			close(listener);
+		}
+		return EXIT_FAILURE;
+	}
+
+	while (1) {
+		int connection = accept(listener, NULL, NULL);
+		int copy = -1;
+		FILE *in = NULL;
+		FILE *out = NULL;
+
+		if (connection < 0) {
+			if (errno == EINTR || errno == ECONNABORTED) {
+				continue;
+			}
+			printf("[SERVICE.cpp--service_listen--ERROR] cannot accept a connection on %s\n", path);
+			break;
+		}
+
+		/*
+		** the connection gets a stream for each direction, closing both closes the socket.
+		*/
+		if ((copy = dup(connection)) < 0 || (in = fdopen(connection, "rb")) == NULL || (out = fdopen(copy, "wb")) == NULL) {
+			printf("[SERVICE.cpp--service_listen--ERROR] cannot open the streams of a connection\n");
+			if (in != NULL) {
+				fclose(in);
+			}
+			else {
+				close(connection);
+			}
+			if (copy >= 0) {
+				close(copy);
+			}
+			continue;
+		}
+		service_run(service, in, out);
+		fclose(in);
+		fclose(out);
+	}
+
+	close(listener);
+	return EXIT_FAILURE;
+#endif
+}
+
+/*stop the workers and release the service*/
+void service_destroy(Solver_Service *service)
+{
+	thread_pool_destroy(service->pool);
+	for (int i = 0; i < service->worker_number; i++) {
+		Service_Worker *worker = service->workers + i;
+
+		graph_free(&worker->graph);
+		ga_run_free(&worker->run);
+		free(worker->links);
+		free(worker->marks);
+		free(worker->settings);
+		free(worker->packed);
+	}
+	for (int i = 0; i < service->job_number; i++) {
+		free(service->jobs[i].frame);
+	}
+	free(service->workers);
+	free(service->jobs);
+	delete service;
+}
@@ -0,0 +1,68 @@
+#ifndef _HEADER_SERVICE_H
+#define _HEADER_SERVICE_H	1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "problem.h"
+#include "geneticalgorithm.h"
+
+#define SERVICE_MAGIC	"GASV"	/*first 4 bytes the service writes*/
+#define SERVICE_VERSION	1	/*version of the frames below*/
+#define SERVICE_MAX_FRAME	(1 << 28)	/*largest job frame in bytes, a larger size means the stream is broken*/
+#define SERVICE_JOBS_PER_WORKER	2	/*jobs which are read ahead per worker, so a worker never waits for the input*/
+
+#define SERVICE_OK	0	/*the job was solved*/
+#define SERVICE_BAD_FRAME	1	/*the frame does not add up, or its graph is not valid or has a repeated link*/
+#define SERVICE_BAD_CONFIG	2	/*a setting of the job is unknown or out of range*/
+
+/*
+** solver service protocol, native byte order like the graph and results files. the service writes SERVICE_MAGIC and
+** int32 SERVICE_VERSION, then reads job frames until its input ends and writes one reply frame per job. the replies
+** come in the order the jobs finish, the job id tells them apart.
+** a job frame is:
+**	uint32	size of the rest of the frame in bytes
+**	uint32	job id, it is sent back with the reply
+**	int32	node number, edge number, population size (0 means DEFAULT_POP_SIZE)
+**	uint64	seed, the job is solved like genetic_algorithm with a RNG_DEFAULT stream seeded with it
+**	int32	length of the settings
+**	char	settings, "key=value" lines applied to the config of the service (see config.h). '#' starts a comment
+**	int32	links, 2 x edge number of them, the two ends of each link. nodes are counted from 0 and links must be distinct,
+**		a job with a repeated link is answered with SERVICE_BAD_FRAME
+** a reply frame is:
+**	uint32	size of the rest of the frame in bytes
+**	uint32	job id
+**	int32	status, SERVICE_OK or an error
+** then for SERVICE_OK:
+**	int32	success, loop times, node number
+**	double	evaluation times, avoided evaluations
+**	int64	nanoseconds the job took in the service
+**	int32	trace length
+**	trace length points of the convergence trace, each an int32 generation, a double evaluation times and a double fitness
+**	uint8	best solution, 2 bits per gene (see pack_genes)
+** and for an error:
+**	char	message, up to the end of the frame
+*/
+
+/*a solver service, its workers and their buffers outlive the jobs*/
+typedef struct solver_service Solver_Service;
+
+/*
+** create a service with thread_count workers, <= 0 means one per core. each worker keeps a graph and a GA run whose buffers
+** grow to the largest job it has solved, so a job allocates almost nothing. config is the base of the settings of every job,
+** NULL means the defaults.
+*/
+Solver_Service *service_create(int thread_count, GA_Config const *config);
+
+/*serve the jobs of in until it ends, the replies go to out. return the number of jobs served*/
+long service_run(Solver_Service *service, FILE *in, FILE *out);
+
+/*listen on a unix domain socket at path and serve its connections one after another. it only returns on an error*/
+int service_listen(Solver_Service *service, char const *path);
+
+/*stop the workers and release the service*/
+void service_destroy(Solver_Service *service);
+
+#endif
@@ -0,0 +1,140 @@
+#include "solver.h"
+
+/*set options to the GA defaults of config.h, DEFAULT_POP_SIZE chromosomes, seed 0 and no callbacks*/
+void solve_options_default(Solve_Options *options)
+{
+	ga_config_default(&options->config);
+	options->pop_size = DEFAULT_POP_SIZE;
+	options->seed = 0;
+	options->on_progress = NULL;
+	options->should_stop = NULL;
+	options->user = NULL;
+	options->stop = NULL;
+}
+
+/*thread_count >= 2 spreads the generations over a thread pool of its own, which allocates its task queues as it goes*/
+GraphColoringSolver::GraphColoringSolver(int thread_count)
+{
+	memset(&run, 0, sizeof run);
+	memset(&own_graph, 0, sizeof own_graph);
+	pool = thread_count >= 2 ? thread_pool_create(thread_count) : NULL;
+	marks = NULL;
+	mark_capacity = 0;
+	message = NULL;
+}
+
+/*release the workspaces and the thread pool*/
+GraphColoringSolver::~GraphColoringSolver()
+{
+	ga_run_free(&run);
+	graph_free(&own_graph);
+	free(marks);
+	if (pool != NULL) {
+		thread_pool_destroy(pool);
+	}
+}
+
+/*
+** solve graph, it must stay unchanged during the solve. return SOLVER_OK with the outcome in report,
+** or an error status with error() telling why. a solve gives the same result as genetic_algorithm with the same stream.
+*/
+int GraphColoringSolver::solve(Graph const *graph, Solve_Options const *options, Solve_Report *report)
+{
+	long long start = profile_now();
+	Solve_Progress progress;
+	int stopped = 0;
+
+	/*
+	** everything ga_run_restart would stop the program for is checked here first.
+	*/
+	if (graph->node_number < 2 || graph->edge_number < 1) {
+		message = "a graph needs 2 nodes and 1 link";
+		return SOLVER_BAD_GRAPH;
+	}
+	if (mark_capacity < graph->node_number) {
+		free(marks);
+		if ((marks = (int *)malloc(graph->node_number * sizeof(int))) == NULL) {
+			printf("[SOLVER.cpp--solve--ERROR] cannot allocate memory\n");
+			exit(EXIT_FAILURE);
+		}
+		mark_capacity = graph->node_number;
+	}
+	if ((message = check_repeated_links(graph, marks)) != NULL) {
+		return SOLVER_BAD_GRAPH;
+	}
+	if ((message = ga_config_error(&options->config)) != NULL) {
+		return SOLVER_BAD_CONFIG;
+	}
+	if (options->pop_size % 2 != 0 || options->pop_size <= options->config.k_candidate) {
+		message = "the population size must be even and larger than k_candidate";
+		return SOLVER_BAD_CONFIG;
+	}
+
+	rng_seed(&rng, RNG_DEFAULT, options->seed);
+	ga_run_restart(&run, graph, options->pop_size, &options->config, &rng, pool);
+	run.tabu.stop = options->stop;
+
+	progress.generation = 0;
+	progress.eval_times = run.eval_times;
+	progress.best_fitness = run.gbest;
+	if (options->on_progress != NULL) {
+		options->on_progress(&progress, options->user);
+	}
+
+	/*
+	** the loop of genetic_algorithm. the stop flag is checked before every generation, the callbacks are called after it.
+	*/
+	while (run.count < run.config.max_loop && run.gbest != 1.0) {
+		if (options->stop != NULL && options->stop->load(std::memory_order_relaxed) != 0) {
+			stopped = 1;
+			break;
+		}
+		ga_run_step(&run);
+
+		progress.generation = run.count;
+		progress.eval_times = run.eval_times;
+		progress.best_fitness = run.gbest;
+		if (options->on_progress != NULL) {
+			options->on_progress(&progress, options->user);
+		}
+		if (run.gbest != 1.0 && options->should_stop != NULL && options->should_stop(&progress, options->user)) {
+			stopped = 1;
+			break;
+		}
+	}
+
+	report->success = run.gbest == 1.0;
+	report->stopped = stopped;
+	report->generations = run.count;
+	report->eval_times = run.eval_times;
+	report->avoided_times = run.avoided_times;
+	report->best_fitness = run.gbest;
+	report->elapsed_ns = profile_now() - start;
+	report->solution = run.parents->chromos[run.parent_best].solution;
+	report->trace = run.trace.points;
+	report->trace_len = run.trace.len;
+	message = NULL;
+
+	return SOLVER_OK;
+}
+
+/*solve the graph of an edge list (see graph_build), it is built into the solver's own graph*/
+int GraphColoringSolver::solve(int node_number, int edge_number, int const *edges, Solve_Options const *options, Solve_Report *report)
+{
+	if (node_number < 2 || edge_number < 1) {
+		message = "a graph needs 2 nodes and 1 link";
+		return SOLVER_BAD_GRAPH;
+	}
+	if ((message = check_links(node_number, edge_number, edges)) != NULL) {
+		return SOLVER_BAD_GRAPH;
+	}
+	graph_build(&own_graph, node_number, edge_number, edges);
+
+	return solve(&own_graph, options, report);
+}
+
+/*what was wrong with the input of the last solve which did not return SOLVER_OK*/
+char const *GraphColoringSolver::error() const
+{
+	return message;
+}
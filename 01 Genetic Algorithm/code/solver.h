@@ -0,0 +1,100 @@
+#ifndef _HEADER_SOLVER_H
+#define _HEADER_SOLVER_H	1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include "problem.h"
+#include "geneticalgorithm.h"
+
+#define SOLVER_OK	0	/*the solve ran, see Solve_Report for its outcome*/
+#define SOLVER_BAD_GRAPH	1	/*the graph has fewer than 2 nodes or 1 link, or a link is not valid or repeated*/
+#define SOLVER_BAD_CONFIG	2	/*a parameter or the population size is out of range*/
+
+/*where a solve is, it is passed to the callbacks*/
+typedef struct Solve_Progress {
+	int generation;	/*generations so far, 0 is the first population*/
+	double eval_times;	/*evaluations so far*/
+	double best_fitness;	/*best fitness so far, 1.0 means the graph is colored*/
+} Solve_Progress;
+
+/*called after the first population and after every generation*/
+typedef void(*Progress_Callback)(Solve_Progress const *progress, void *user);
+
+/*called after every generation, a solve stops early if it returns nonzero*/
+typedef int(*Stop_Callback)(Solve_Progress const *progress, void *user);
+
+/*how to solve a graph, solve_options_default sets the defaults*/
+typedef struct Solve_Options {
+	GA_Config config;	/*operators and parameters of the GA*/
+	int pop_size;	/*population size, even and larger than config.k_candidate*/
+	uint64_t seed;	/*the solve uses a RNG_DEFAULT stream seeded with it, equal seeds give equal solves*/
+	Progress_Callback on_progress;	/*NULL means no progress is reported*/
+	Stop_Callback should_stop;	/*NULL means a solve only stops when it colors the graph or reaches max_loop*/
+	void *user;	/*passed to the callbacks*/
+	std::atomic<int> const *stop;	/*another thread can set it to stop a solve within a generation or a tabu move, NULL means none*/
+} Solve_Options;
+
+/*
+** outcome of a solve. solution and trace point into the workspaces of the solver,
+** they are valid until the next solve or until the solver is destroyed.
+*/
+typedef struct Solve_Report {
+	int success;	/*1 if the graph is colored*/
+	int stopped;	/*1 if a callback or the stop flag ended the solve early*/
+	int generations;
+	double eval_times;	/*evaluations of the object function, including the local search*/
+	double avoided_times;	/*evaluations skipped because a child was equal to a parent*/
+	double best_fitness;
+	long long elapsed_ns;	/*wall time of the solve*/
+	char const *solution;	/*best coloring, node number genes*/
+	Trace_Point const *trace;	/*convergence trace*/
+	int trace_len;
+} Solve_Report;
+
+/*set options to the GA defaults of config.h, DEFAULT_POP_SIZE chromosomes, seed 0 and no callbacks*/
+void solve_options_default(Solve_Options *options);
+
+/*
+** a 3-coloring GA for embedding in other programs. its graph, populations and workspaces are kept from one solve
+** to the next and only grow, so once they fit the largest graph and population, a solve of a single threaded solver
+** allocates nothing and makes no system calls. it prints nothing, and bad input is reported by a status instead of
+** ending the program; only running out of memory still ends it.
+** a solver is used by one thread at a time, several solvers can run side by side.
+*/
+class GraphColoringSolver {
+public:
+	/*thread_count >= 2 spreads the generations over a thread pool of its own, which allocates its task queues as it goes*/
+	explicit GraphColoringSolver(int thread_count = 1);
+	~GraphColoringSolver();
+
+	GraphColoringSolver(GraphColoringSolver const &) = delete;
+	GraphColoringSolver &operator=(GraphColoringSolver const &) = delete;
+
+	/*
+	** solve graph, it must stay unchanged during the solve. return SOLVER_OK with the outcome in report,
+	** or an error status with error() telling why. a solve gives the same result as genetic_algorithm with the same stream.
+	*/
+	int solve(Graph const *graph, Solve_Options const *options, Solve_Report *report);
+
+	/*solve the graph of an edge list (see graph_build), it is built into the solver's own graph*/
+	int solve(int node_number, int edge_number, int const *edges, Solve_Options const *options, Solve_Report *report);
+
+	/*what was wrong with the input of the last solve which did not return SOLVER_OK*/
+	char const *error() const;
+
+private:
+	GA_Run run;	/*it is pointed to by its generation, so a solver can be neither copied nor moved*/
+	Graph own_graph;	/*graph of the edge list solves*/
+	Thread_Pool *pool;	/*NULL for one thread*/
+	int *marks;	/*workspace of check_repeated_links*/
+	int mark_capacity;
+	Rng rng;
+	char const *message;
+};
+
+#endif
@@ -0,0 +1,218 @@
+#include "tabu.h"
+
+#include <limits.h>
+
+/*allocate the workspace of a tabu search on graphs of node_number nodes*/
+void tabu_init(Tabu_Search *tabu, int node_number)
+{
+	tabu->node_number = node_number;
+	tabu->gamma = (int *)malloc((size_t)node_number * TABU_COLORS * sizeof(int));
+	tabu->tabu_until = (long long *)calloc((size_t)node_number * TABU_COLORS, sizeof(long long));
+	tabu->conflict_nodes = (int *)malloc(node_number * sizeof(int));
+	tabu->positions = (int *)malloc(node_number * sizeof(int));
+	tabu->len = 0;
+	tabu->best = (char *)malloc(node_number);
+	tabu->iteration = 0;
+	tabu->horizon = 0;
+	tabu->stop = NULL;
+
+	if (tabu->gamma == NULL || tabu->tabu_until == NULL || tabu->conflict_nodes == NULL || tabu->positions == NULL || tabu->best == NULL) {
+		printf("[TABU.cpp--tabu_init--ERROR] cannot allocate memory\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+/*forget the tabu list and the move count, so the next search runs like one on a new workspace*/
+void tabu_reset(Tabu_Search *tabu)
+{
+	memset(tabu->tabu_until, 0, (size_t)tabu->node_number * TABU_COLORS * sizeof(long long));
+	tabu->iteration = 0;
+	tabu->horizon = 0;
+}
+
+/*release the memory held by the workspace*/
+void tabu_free(Tabu_Search *tabu)
+{
+	free(tabu->gamma);
+	free(tabu->tabu_until);
+	free(tabu->conflict_nodes);
+	free(tabu->positions);
+	free(tabu->best);
+	memset(tabu, 0, sizeof *tabu);
+}
+
+/*add node to the conflict nodes*/
+static inline void add_conflict_node(Tabu_Search *tabu, int node)
+{
+	tabu->positions[node] = tabu->len;
+	tabu->conflict_nodes[tabu->len++] = node;
+}
+
+/*remove node from the conflict nodes, the last one takes its place*/
+static inline void remove_conflict_node(Tabu_Search *tabu, int node)
+{
+	int last = tabu->conflict_nodes[--tabu->len];
+
+	tabu->conflict_nodes[tabu->positions[node]] = last;
+	tabu->positions[last] = tabu->positions[node];
+	tabu->positions[node] = -1;
+}
+
+/*whether the search was told to stop, another thread may set the flag at any time*/
+static inline int tabu_stopped(Tabu_Search const *tabu)
+{
+	return tabu->stop != NULL && tabu->stop->load(std::memory_order_relaxed) != 0;
+}
+
+/*recolor node to color and update gamma, the conflict nodes and the conflict state, it costs O(degree)*/
+static void tabu_move(Tabu_Search *tabu, Graph const *graph, char *solution, Conflict_State *state, int node, char color)
+{
+	char old_color = solution[node];
+	int const *gamma = tabu->gamma + node * TABU_COLORS;
+
+	for (int k = graph->offsets[node]; k < graph->offsets[node + 1]; k++) {
+		int j = graph->neighbours[k];
+		int *row = tabu->gamma + j * TABU_COLORS;
+
+		row[(int)old_color] -= 1;
+		row[(int)color] += 1;
+		if (solution[j] == old_color) {
+			if (--state->node_conflicts[j] == 0) {
+				remove_conflict_node(tabu, j);
+			}
+		}
+		else if (solution[j] == color) {
+			if (state->node_conflicts[j]++ == 0) {
+				add_conflict_node(tabu, j);
+			}
+		}
+	}
+
+	state->conflict += gamma[(int)color] - gamma[(int)old_color];
+	state->node_conflicts[node] = gamma[(int)color];
+	if (gamma[(int)color] == 0 && tabu->positions[node] >= 0) {
+		remove_conflict_node(tabu, node);
+	}
+	else if (gamma[(int)color] > 0 && tabu->positions[node] < 0) {
+		add_conflict_node(tabu, node);
+	}
+	solution[node] = color;
+}
+
+/*
+** TabuCol: starting from solution, repeatedly make the best move of a conflict node to another color which is not tabu,
+** at most iterations moves or until no conflict is left or tabu->stop is set. every search starts with an empty tabu list. a move is tabu for
+** tenure + alpha * (conflict nodes) iterations after the node left that color, tenure is drawn from 0 ... tenure - 1.
+** a tabu move is still taken if it gives fewer conflicts than the best solution so far (aspiration).
+** solution and its conflict state are set to the best solution found.
+** return the number of candidate moves evaluated.
+*/
+int tabu_search(Tabu_Search *tabu, Graph const *graph, char *solution, Conflict_State *state,
+	int iterations, int tenure, double alpha, Rng *rng)
+{
+	int node_number = graph->node_number;
+	int eval_times = 0;
+	int best_conflict = state->conflict;
+	long long last = 0;
+
+	/*
+	** the search starts behind every entry of the searches before, which were made for other solutions.
+	*/
+	if (tabu->iteration < tabu->horizon) {
+		tabu->iteration = tabu->horizon;
+	}
+	last = tabu->iteration + iterations;
+
+	/*
+	** build gamma and the conflict nodes, O(links). the conflict state already has the conflicts of each node.
+	*/
+	memset(tabu->gamma, 0, (size_t)node_number * TABU_COLORS * sizeof(int));
+	tabu->len = 0;
+	for (int i = 0; i < node_number; i++) {
+		int *row = tabu->gamma + i * TABU_COLORS;
+
+		for (int k = graph->offsets[i]; k < graph->offsets[i + 1]; k++) {
+			row[(int)solution[graph->neighbours[k]]] += 1;
+		}
+		tabu->positions[i] = -1;
+		if (state->node_conflicts[i] > 0) {
+			add_conflict_node(tabu, i);
+		}
+	}
+	memcpy(tabu->best, solution, node_number);
+
+	for (; tabu->iteration < last && state->conflict > 0 && !tabu_stopped(tabu); tabu->iteration++) {
+		int best_delta = INT_MAX;
+		int ties = 0;
+		int move_node = -1;
+		char move_color = 0;
+
+		/*
+		** best move over the conflict nodes and their other colors, ties are broken at random.
+		** only conflict nodes are tried: moving a node without conflict cannot remove one.
+		*/
+		for (int i = 0; i < tabu->len; i++) {
+			int node = tabu->conflict_nodes[i];
+			int const *row = tabu->gamma + node * TABU_COLORS;
+			char current = solution[node];
+
+			for (char color = 0; color < TABU_COLORS; color++) {
+				int delta = row[(int)color] - row[(int)current];
+
+				if (color == current) {
+					continue;
+				}
+				eval_times += 1;
+
+				/*a tabu move is allowed only if it beats the best solution (aspiration)*/
+				if (tabu->tabu_until[node * TABU_COLORS + color] > tabu->iteration && state->conflict + delta >= best_conflict) {
+					continue;
+				}
+				if (delta < best_delta) {
+					best_delta = delta;
+					ties = 1;
+					move_node = node;
+					move_color = color;
+				}
+				else if (delta == best_delta && rng_below(rng, ++ties) == 0) {
+					move_node = node;
+					move_color = color;
+				}
+			}
+		}
+
+		/*
+		** all moves are tabu: move a random conflict node to a random other color.
+		*/
+		if (move_node < 0) {
+			move_node = tabu->conflict_nodes[rng_below(rng, tabu->len)];
+			move_color = (char)((solution[move_node] + 1 + rng_below(rng, TABU_COLORS - 1)) % TABU_COLORS);
+		}
+
+		long long until = tabu->iteration + (tenure > 0 ? rng_below(rng, tenure) : 0) + (long long)(alpha * tabu->len);
+
+		tabu->tabu_until[move_node * TABU_COLORS + solution[move_node]] = until;
+		if (until > tabu->horizon) {
+			tabu->horizon = until;
+		}
+		tabu_move(tabu, graph, solution, state, move_node, move_color);
+
+		if (state->conflict < best_conflict) {
+			best_conflict = state->conflict;
+			memcpy(tabu->best, solution, node_number);
+		}
+	}
+
+	/*
+	** go back to the best solution if the search left it.
+	*/
+	if (state->conflict > best_conflict) {
+		for (int i = 0; i < node_number; i++) {
+			if (solution[i] != tabu->best[i]) {
+				tabu_move(tabu, graph, solution, state, i, tabu->best[i]);
+			}
+		}
+	}
+
+	return eval_times;
+}
@@ -0,0 +1,53 @@
+#ifndef _HEADER_TABU_H
+#define _HEADER_TABU_H	1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+
+#include "rng.h"
+#include "problem.h"
+
+#define TABU_COLORS	3	/*number of colors*/
+
+/*
+** workspace of TabuCol, a tabu search over single node recolorings. it is allocated once and reused by every search
+** on graphs of up to node_number nodes, so a search allocates nothing.
+*/
+typedef struct Tabu_Search {
+	int node_number;	/*largest node number of the graphs the workspace fits*/
+	int *gamma;	/*gamma[node * TABU_COLORS + color] is the number of neighbours of node which have color*/
+	long long *tabu_until;	/*laid out like gamma, the move of node back to color is tabu until this iteration*/
+	int *conflict_nodes;	/*nodes whose conflict is not 0, in no order*/
+	int *positions;	/*index of each node in conflict_nodes, -1 if it has no conflict*/
+	int len;	/*number of conflict nodes*/
+	char *best;	/*best solution found by the current search*/
+	long long iteration;	/*move count of the tabu list, it only grows*/
+	long long horizon;	/*latest iteration any entry of tabu_until is tabu until. a search starts its moves there, so the entries
+		of the searches before it, which were made for other solutions, have all expired and the list needs no clearing*/
+	std::atomic<int> const *stop;	/*a search makes no more moves once this flag is set, NULL means it is never stopped*/
+} Tabu_Search;
+
+/*allocate the workspace of a tabu search on graphs of node_number nodes*/
+void tabu_init(Tabu_Search *tabu, int node_number);
+
+/*forget the tabu list and the move count, so the next search runs like one on a new workspace*/
+void tabu_reset(Tabu_Search *tabu);
+
+/*release the memory held by the workspace*/
+void tabu_free(Tabu_Search *tabu);
+
+/*
+** TabuCol: starting from solution, repeatedly make the best move of a conflict node to another color which is not tabu,
+** at most iterations moves or until no conflict is left or tabu->stop is set. every search starts with an empty tabu list. a move is tabu for
+** tenure + alpha * (conflict nodes) iterations after the node left that color, tenure is drawn from 0 ... tenure - 1.
+** a tabu move is still taken if it gives fewer conflicts than the best solution so far (aspiration).
+** solution and its conflict state are set to the best solution found.
+** return the number of candidate moves evaluated.
+*/
+int tabu_search(Tabu_Search *tabu, Graph const *graph, char *solution, Conflict_State *state,
+	int iterations, int tenure, double alpha, Rng *rng);
+
+#endif
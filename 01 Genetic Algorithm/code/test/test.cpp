@@ -0,0 +1,443 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../rng.h"
+#include "../problem.h"
+#include "../geneticalgorithm.h"
+#include "../campaign.h"
+#include "../graphio.h"
+#include "../solver.h"
+#include "../service.h"
+#include "../results.h"
+
+/*
+** tests of the GA. it is a program of its own like the benchmark, build it from the code directory with the
+** sources of the GA but without main.cpp, for example:
+**	g++ -std=c++17 -O2 -pthread test/test.cpp $(ls *.cpp | grep -v main.cpp) -o test
+** usage: test [directory], the files of the tests are written to directory, /tmp if it is not given.
+** a line is printed per check which fails, the exit status is EXIT_FAILURE if any did. the checks of errors
+** which stop the program run in a child process, so the tests need a POSIX system.
+*/
+
+#define TEST_SEED	20170109UL	/*all random graphs and runs are drawn from this seed*/
+#define TEST_PATH_SIZE	300
+
+static int failures = 0;	/*number of checks which failed*/
+static char const *directory = "/tmp";	/*where the files of the tests are written*/
+
+/*count and report a check which failed*/
+#define CHECK(condition)	do { if (!(condition)) { failures += 1; printf("FAILED %s:%d: %s\n", __FILE__, __LINE__, #condition); } } while (0)
+
+/*an operation which is expected to stop the program*/
+typedef void(*Test_Op)(char const *path);
+
+/*full path of a file of the tests*/
+static void test_path(char *path, char const *file_name)
+{
+	snprintf(path, TEST_PATH_SIZE, "%s/%s", directory, file_name);
+}
+
+/*write text to the file at path*/
+static void write_text(char const *path, char const *text)
+{
+	FILE *file = fopen(path, "wb");
+
+	if (file == NULL || fwrite(text, 1, strlen(text), file) != strlen(text)) {
+		printf("[TEST.cpp--write_text--ERROR] cannot write %s\n", path);
+		exit(EXIT_FAILURE);
+	}
+	fclose(file);
+}
+
+/*run op on path in a child process, return 1 if it stopped the program with EXIT_FAILURE. its output is dropped*/
+static int stops_program(Test_Op op, char const *path)
+{
+	int status = 0;
+	pid_t child = 0;
+
+	fflush(stdout);
+	if ((child = fork()) == 0) {
+		if (freopen("/dev/null", "w", stdout) == NULL) {
+			_exit(EXIT_SUCCESS);
+		}
+		op(path);
+		_exit(EXIT_SUCCESS);
+	}
+	waitpid(child, &status, 0);
+
+	return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_FAILURE;
+}
+
+static void op_load(char const *path)
+{
+	Graph graph = {};
+
+	graph_load(&graph, path);
+	graph_free(&graph);
+}
+
+/*whether two graphs have the same adjacency lists*/
+static int same_graph(Graph const *a, Graph const *b)
+{
+	return a->node_number == b->node_number && a->edge_number == b->edge_number &&
+		memcmp(a->offsets, b->offsets, (a->node_number + 1) * sizeof(int)) == 0 &&
+		memcmp(a->neighbours, b->neighbours, 2 * (size_t)a->edge_number * sizeof(int)) == 0;
+}
+
+/*write a binary graph file of graph, then change the int32 at index (counted after the header) to value*/
+static void write_broken_graph(char const *path, Graph const *graph, long index, int32_t value)
+{
+	FILE *file = NULL;
+
+	graph_save_binary(graph, path, NULL);
+	if ((file = fopen(path, "r+b")) == NULL || fseek(file, 32 + index * (long)sizeof(int32_t), SEEK_SET) != 0 ||
+		fwrite(&value, sizeof value, 1, file) != 1) {
+		printf("[TEST.cpp--write_broken_graph--ERROR] cannot write %s\n", path);
+		exit(EXIT_FAILURE);
+	}
+	fclose(file);
+}
+
+/*DIMACS files: comments, links in both directions and self links, and files which are not graphs*/
+static void test_dimacs(void)
+{
+	char path[TEST_PATH_SIZE];
+	Graph graph = {};
+
+	test_path(path, "test.col");
+	write_text(path, "c a triangle and a tail\np edge 4 7\ne 1 2\ne 2 1\ne 2 3\ne 3 1\ne 3 3\ne 3 4\ne 4 3\n");
+	graph_load(&graph, path);
+	CHECK(graph.node_number == 4);
+	CHECK(graph.edge_number == 4);
+	CHECK(graph.offsets[4] == 8);
+	CHECK(graph.offsets[3] - graph.offsets[2] == 3);
+	graph_free(&graph);
+
+	write_text(path, "p edge 5 0\n");
+	CHECK(stops_program(op_load, path));
+	write_text(path, "p edge 3 1\ne 2 2\n");
+	CHECK(stops_program(op_load, path));
+	write_text(path, "p edge 1 0\n");
+	CHECK(stops_program(op_load, path));
+	write_text(path, "p edge 3 1\ne 1 4\n");
+	CHECK(stops_program(op_load, path));
+}
+
+/*binary graph files: a saved graph maps back to the same graph, and broken adjacency lists are found*/
+static void test_binary(void)
+{
+	char path[TEST_PATH_SIZE];
+	Graph graph = {};
+	Graph mapped = {};
+	char *coloring = NULL;
+	char const *mapped_coloring = NULL;
+	Rng rng;
+
+	rng_seed(&rng, RNG_DEFAULT, TEST_SEED);
+	generate_random_graph(&graph, 90, 5.0f, &rng);
+	if ((coloring = (char *)malloc(graph.node_number)) == NULL) {
+		printf("[TEST.cpp--test_binary--ERROR] cannot allocate memory\n");
+		exit(EXIT_FAILURE);
+	}
+	planted_coloring(graph.node_number, coloring);
+
+	test_path(path, "test.graph");
+	graph_save_binary(&graph, path, coloring);
+	graph_map_binary(&mapped, path, &mapped_coloring);
+	CHECK(mapped.mapping != NULL);
+	CHECK(same_graph(&graph, &mapped));
+	CHECK(mapped_coloring != NULL && memcmp(mapped_coloring, coloring, graph.node_number) == 0);
+	CHECK(fitness(&mapped, coloring) == 1.0);
+	graph_free(&mapped);
+
+	/*
+	** offsets which decrease, a neighbour which is not a node, and a node which is its own neighbour.
+	*/
+	write_broken_graph(path, &graph, 1, graph.offsets[2] + 1);
+	CHECK(stops_program(op_load, path));
+	write_broken_graph(path, &graph, graph.node_number + 1, graph.node_number);
+	CHECK(stops_program(op_load, path));
+	write_broken_graph(path, &graph, graph.node_number + 1, -1);
+	CHECK(stops_program(op_load, path));
+	write_broken_graph(path, &graph, graph.node_number + 1, 0);
+	CHECK(stops_program(op_load, path));
+	CHECK(graph.offsets[1] >= 2);
+	write_broken_graph(path, &graph, graph.node_number + 2, graph.neighbours[0]);
+	CHECK(stops_program(op_load, path));
+
+	free(coloring);
+	graph_free(&graph);
+}
+
+/*a campaign on the graph of a file, as main runs it with graph=path*/
+static void test_campaign_file(void)
+{
+	char path[TEST_PATH_SIZE];
+	Graph graph = {};
+	Graph loaded = {};
+	Rng rng;
+	float d_list[1] = { 0.0f };
+	int sr_list[1] = { 0 };
+	double avg_eval_list[1] = { 0.0 };
+	Campaign campaign;
+
+	rng_seed(&rng, RNG_DEFAULT, TEST_SEED);
+	generate_random_graph(&graph, 60, 2.0f, &rng);
+	test_path(path, "campaign.graph");
+	graph_save_binary(&graph, path, NULL);
+	graph_load(&loaded, path);
+
+	memset(&campaign, 0, sizeof campaign);
+	campaign.node_number = loaded.node_number;
+	campaign.graph = &loaded;
+	campaign.pop_size = DEFAULT_POP_SIZE;
+	campaign.max_run = 4;
+	campaign.d_number = 1;
+	campaign.d_list = d_list;
+	campaign.thread_count = 2;
+	campaign.run_thread_count = 1;
+	campaign.seed = TEST_SEED;
+	campaign.rng_kind = RNG_DEFAULT;
+	campaign.sr_list = sr_list;
+	campaign.avg_eval_list = avg_eval_list;
+	run_campaign(&campaign);
+	CHECK(sr_list[0] >= 1);
+	CHECK(sr_list[0] == 0 || avg_eval_list[0] > 0.0);
+
+	graph_free(&loaded);
+	graph_free(&graph);
+}
+
+/*a trace keeps every change which is stride generations after the point before the last one, the latest value always*/
+static void test_trace(void)
+{
+	Trace trace;
+
+	trace_init(&trace, 10);
+	trace_add(&trace, 0, 1.0, 0.5);
+	trace_add(&trace, 2, 2.0, 0.7);
+	trace_add(&trace, 50, 3.0, 0.8);
+	trace_add(&trace, 51, 4.0, 0.9);
+	CHECK(trace.len == 4);
+	CHECK(trace_fitness_at(trace.points, trace.len, 30) == 0.7);
+	CHECK(trace_fitness_at(trace.points, trace.len, 51) == 0.9);
+
+	/*
+	** 55 is within the stride of 50, the point before the last one, so it moves the last point.
+	*/
+	trace_add(&trace, 55, 5.0, 0.95);
+	trace_add(&trace, 55, 5.0, 0.95);
+	CHECK(trace.len == 4);
+	CHECK(trace.points[3].generation == 55 && trace.points[3].fitness == 0.95);
+	CHECK(trace_fitness_at(trace.points, trace.len, 54) == 0.8);
+	CHECK(trace_fitness_at(trace.points, trace.len, -1) == 0.0);
+
+	trace_clear(&trace);
+	CHECK(trace.len == 0);
+	trace_free(&trace);
+}
+
+/*copy the first bytes of the file at from to the file at to, then write value at offset of it if offset is not negative*/
+static void copy_broken_file(char const *from, char const *to, long bytes, long offset, int32_t value)
+{
+	FILE *in = fopen(from, "rb");
+	FILE *out = fopen(to, "wb");
+	char *buffer = (char *)malloc(bytes);
+
+	if (in == NULL || out == NULL || buffer == NULL || fread(buffer, 1, bytes, in) != (size_t)bytes) {
+		printf("[TEST.cpp--copy_broken_file--ERROR] cannot copy %s\n", from);
+		exit(EXIT_FAILURE);
+	}
+	if (offset >= 0) {
+		memcpy(buffer + offset, &value, sizeof value);
+	}
+	fwrite(buffer, 1, bytes, out);
+	fclose(in);
+	fclose(out);
+	free(buffer);
+}
+
+/*a results file exports to csv, and a truncated or broken one, or a csv which cannot be written, is a failure*/
+static void test_results(void)
+{
+	char path[TEST_PATH_SIZE];
+	char bin_path[TEST_PATH_SIZE];
+	char broken_path[TEST_PATH_SIZE];
+	char csv_path[TEST_PATH_SIZE];
+	Result_Sink *sink = NULL;
+	FILE *file = NULL;
+	long bytes = 0;
+	int lines = 0;
+	int c = 0;
+
+	test_path(path, "results");
+	test_path(bin_path, "results.bin");
+	test_path(broken_path, "broken.bin");
+	test_path(csv_path, "export.csv");
+
+	sink = result_sink_open(path, 0, 0);
+	for (int run = 0; run < 3; run++) {
+		Result *result = result_create(30, 2);
+
+		memset(result->solution, run, 30);
+		result->trace[0].generation = 0;
+		result->trace[0].eval_times = 1.0;
+		result->trace[0].fitness = 0.5;
+		result->trace[1].generation = 7;
+		result->trace[1].eval_times = 2.0;
+		result->trace[1].fitness = 1.0;
+		result->success = 1;
+		result->loop_times = 7;
+		result->eval_times = 2.0;
+		result->avoided_times = 0.0;
+		result->start_seconds = 0;
+		result->end_seconds = 1;
+		result_sink_put(sink, 0, 2.0f, run, result);
+	}
+	result_sink_close(sink);
+
+	CHECK(export_results_csv(bin_path, csv_path) == EXIT_SUCCESS);
+	if ((file = fopen(csv_path, "r")) != NULL) {
+		while ((c = fgetc(file)) != EOF) {
+			lines += c == '\n';
+		}
+		fclose(file);
+	}
+	CHECK(lines == 1 + 3 * 2);
+
+	/*
+	** the header takes 8 bytes, the node number of the first record follows its size and 4 ints.
+	*/
+	if ((file = fopen(bin_path, "rb")) == NULL || fseek(file, 0, SEEK_END) != 0 || (bytes = ftell(file)) <= 8) {
+		CHECK(!"the results file was not written");
+		return;
+	}
+	fclose(file);
+	copy_broken_file(bin_path, broken_path, bytes - 5, -1, 0);
+	CHECK(export_results_csv(broken_path, csv_path) == EXIT_FAILURE);
+	copy_broken_file(bin_path, broken_path, bytes, 8 + 4 + 16, 1 << 30);
+	CHECK(export_results_csv(broken_path, csv_path) == EXIT_FAILURE);
+	CHECK(export_results_csv(bin_path, "/dev/full") == EXIT_FAILURE);
+}
+
+/*the solver refuses an edge list or a graph with a repeated link, whichever way round it is repeated*/
+static void test_solver_repeated_link(void)
+{
+	int edges[2 * 49];
+	int edge_number = 0;
+	Graph graph = {};
+	GraphColoringSolver solver;
+	Solve_Options options;
+	Solve_Report report;
+
+	/*
+	** every link between 3 parts of 4 nodes, 48 links, then the first one again the other way round.
+	*/
+	for (int u = 0; u < 12; u++) {
+		for (int v = u + 1; v < 12; v++) {
+			if (u / 4 != v / 4) {
+				edges[2 * edge_number] = u;
+				edges[2 * edge_number + 1] = v;
+				edge_number += 1;
+			}
+		}
+	}
+	edges[2 * edge_number] = edges[1];
+	edges[2 * edge_number + 1] = edges[0];
+
+	solve_options_default(&options);
+	options.seed = TEST_SEED;
+	CHECK(solver.solve(12, edge_number + 1, edges, &options, &report) == SOLVER_BAD_GRAPH);
+	CHECK(solver.error() != NULL && strstr(solver.error(), "repeated") != NULL);
+
+	graph_build(&graph, 12, edge_number + 1, edges);
+	CHECK(solver.solve(&graph, &options, &report) == SOLVER_BAD_GRAPH);
+
+	CHECK(solver.solve(12, edge_number, edges, &options, &report) == SOLVER_OK);
+	CHECK(solver.error() == NULL);
+	CHECK(report.success == 1);
+
+	graph_free(&graph);
+}
+
+/*write a job frame of the service for the edge list edges*/
+static void write_job(FILE *file, uint32_t id, int32_t node_number, int32_t edge_number, int const *edges)
+{
+	int32_t numbers[3] = { node_number, edge_number, 0 };
+	uint64_t seed = TEST_SEED;
+	int32_t settings_length = 0;
+	uint32_t size = (uint32_t)(sizeof id + sizeof numbers + sizeof seed + sizeof settings_length + 2 * edge_number * sizeof(int32_t));
+
+	fwrite(&size, sizeof size, 1, file);
+	fwrite(&id, sizeof id, 1, file);
+	fwrite(numbers, sizeof numbers, 1, file);
+	fwrite(&seed, sizeof seed, 1, file);
+	fwrite(&settings_length, sizeof settings_length, 1, file);
+	fwrite(edges, sizeof(int32_t), 2 * edge_number, file);
+}
+
+/*the service answers a job with a repeated link with SERVICE_BAD_FRAME, and goes on with the next job*/
+static void test_service_repeated_link(void)
+{
+	int edges[] = { 0, 1, 1, 2, 2, 3, 3, 0, 2, 1 };
+	FILE *in = tmpfile();
+	FILE *out = tmpfile();
+	Solver_Service *service = service_create(1, NULL);
+	char magic[4];
+	int32_t version = 0;
+	int statuses[2] = { -1, -1 };
+
+	if (in == NULL || out == NULL) {
+		printf("[TEST.cpp--test_service_repeated_link--ERROR] cannot open a temporary file\n");
+		exit(EXIT_FAILURE);
+	}
+	write_job(in, 0, 4, 5, edges);
+	write_job(in, 1, 4, 4, edges);
+	rewind(in);
+	CHECK(service_run(service, in, out) == 2);
+	service_destroy(service);
+
+	rewind(out);
+	CHECK(fread(magic, 1, 4, out) == 4 && memcmp(magic, SERVICE_MAGIC, 4) == 0);
+	CHECK(fread(&version, sizeof version, 1, out) == 1 && version == SERVICE_VERSION);
+	for (int k = 0; k < 2; k++) {
+		uint32_t size = 0;
+		uint32_t id = 0;
+		int32_t status = 0;
+
+		if (fread(&size, sizeof size, 1, out) != 1 || fread(&id, sizeof id, 1, out) != 1 ||
+			fread(&status, sizeof status, 1, out) != 1 || id > 1 || fseek(out, size - sizeof id - sizeof status, SEEK_CUR) != 0) {
+			CHECK(!"a reply of the service is broken");
+			break;
+		}
+		statuses[id] = status;
+	}
+	CHECK(statuses[0] == SERVICE_BAD_FRAME);
+	CHECK(statuses[1] == SERVICE_OK);
+
+	fclose(in);
+	fclose(out);
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc > 1) {
+		directory = argv[1];
+	}
+
+	test_trace();
+	test_results();
+	test_dimacs();
+	test_binary();
+	test_campaign_file();
+	test_solver_repeated_link();
+	test_service_repeated_link();
+
+	printf("%s, %d checks failed\n", failures == 0 ? "passed" : "FAILED", failures);
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
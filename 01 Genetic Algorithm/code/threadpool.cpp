@@ -0,0 +1,160 @@
+#include "threadpool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*a submitted task*/
+typedef struct Task {
+	Task_Func func;
+	void *arg;
+} Task;
+
+/*task queue of one worker*/
+typedef struct Task_Queue {
+	std::mutex lock;
+	std::deque<Task> tasks;
+} Task_Queue;
+
+struct thread_pool {
+	int size;	/*number of workers*/
+	std::vector<std::thread> threads;
+	std::vector<Task_Queue> queues;	/*one queue per worker*/
+
+	std::mutex lock;	/*protects stop, and orders queued increments against sleeping workers*/
+	std::condition_variable wake;	/*signaled when a task is queued or the pool stops*/
+	std::condition_variable idle;	/*signaled when pending drops to 0*/
+	std::atomic<long> queued;	/*tasks in queues, not taken by any worker yet*/
+	std::atomic<long> pending;	/*tasks submitted but not finished*/
+	std::atomic<unsigned> next_queue;	/*round robin position for tasks submitted from outside*/
+	bool stop;
+
+	explicit thread_pool(int n) : size(n), queues(n), queued(0), pending(0), next_queue(0), stop(false) {}
+};
+
+/*the pool and worker index of the current thread, so tasks submitted by a worker stay on its queue*/
+static thread_local Thread_Pool *current_pool = NULL;
+static thread_local int current_worker = -1;
+
+/*take a task: first from the back of the worker's own queue, then from the front of the other queues*/
+static int take_task(Thread_Pool *pool, int worker, Task *task)
+{
+	for (int k = 0; k < pool->size; k++) {
+		Task_Queue *queue = &pool->queues[(worker + k) % pool->size];
+		std::lock_guard<std::mutex> guard(queue->lock);
+
+		if (!queue->tasks.empty()) {
+			if (k == 0) {
+				*task = queue->tasks.back();
+				queue->tasks.pop_back();
+			}
+			else {
+				*task = queue->tasks.front();
+				queue->tasks.pop_front();
+			}
+			pool->queued -= 1;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/*main loop of a worker thread*/
+static void worker_main(Thread_Pool *pool, int worker)
+{
+	Task task;
+
+	current_pool = pool;
+	current_worker = worker;
+
+	while (1) {
+		if (take_task(pool, worker, &task)) {
+			task.func(task.arg, worker);
+
+			if (--pool->pending == 0) {
+				std::lock_guard<std::mutex> guard(pool->lock);
+				pool->idle.notify_all();
+			}
+			continue;
+		}
+
+		/*
+		** no task anywhere. sleep until one is queued, the pool stops only after all tasks are taken.
+		*/
+		std::unique_lock<std::mutex> guard(pool->lock);
+		pool->wake.wait(guard, [pool] { return pool->queued > 0 || pool->stop; });
+		if (pool->stop && pool->queued == 0) {
+			break;
+		}
+	}
+}
+
+/*create a thread pool, thread_count <= 0 means one thread per core*/
+Thread_Pool *thread_pool_create(int thread_count)
+{
+	if (thread_count <= 0) {
+		thread_count = (int)std::thread::hardware_concurrency();
+		if (thread_count <= 0) {
+			thread_count = 1;
+		}
+	}
+
+	Thread_Pool *pool = new Thread_Pool(thread_count);
+
+	for (int i = 0; i < thread_count; i++) {
+		pool->threads.push_back(std::thread(worker_main, pool, i));
+	}
+
+	return pool;
+}
+
+/*number of workers of the pool*/
+int thread_pool_size(Thread_Pool const *pool)
+{
+	return pool->size;
+}
+
+/*submit a task. a task submitted from a worker goes to the queue of that worker*/
+void thread_pool_submit(Thread_Pool *pool, Task_Func func, void *arg)
+{
+	int worker = current_pool == pool ? current_worker : (int)(pool->next_queue++ % pool->size);
+	Task task = { func, arg };
+
+	pool->pending += 1;
+	{
+		std::lock_guard<std::mutex> guard(pool->queues[worker].lock);
+		pool->queues[worker].tasks.push_back(task);
+	}
+	{
+		std::lock_guard<std::mutex> guard(pool->lock);
+		pool->queued += 1;
+	}
+	pool->wake.notify_one();
+}
+
+/*wait until all submitted tasks are finished*/
+void thread_pool_wait(Thread_Pool *pool)
+{
+	std::unique_lock<std::mutex> guard(pool->lock);
+	pool->idle.wait(guard, [pool] { return pool->pending == 0; });
+}
+
+/*stop all workers and release the pool, submitted tasks are finished first*/
+void thread_pool_destroy(Thread_Pool *pool)
+{
+	{
+		std::lock_guard<std::mutex> guard(pool->lock);
+		pool->stop = true;
+	}
+	pool->wake.notify_all();
+
+	for (size_t i = 0; i < pool->threads.size(); i++) {
+		pool->threads[i].join();
+	}
+
+	delete pool;
+}
@@ -0,0 +1,31 @@
+#ifndef _HEADER_THREADPOOL_H
+#define _HEADER_THREADPOOL_H	1
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+** a work-stealing thread pool. each worker owns a task queue, it takes its own tasks from the back
+** and steals the tasks of other workers from the front when its queue is empty.
+*/
+typedef struct thread_pool Thread_Pool;
+
+/*a task, worker is the index of the worker which runs it (0 ... thread_pool_size() - 1)*/
+typedef void(*Task_Func)(void *arg, int worker);
+
+/*create a thread pool, thread_count <= 0 means one thread per core*/
+Thread_Pool *thread_pool_create(int thread_count);
+
+/*number of workers of the pool*/
+int thread_pool_size(Thread_Pool const *pool);
+
+/*submit a task. a task submitted from a worker goes to the queue of that worker*/
+void thread_pool_submit(Thread_Pool *pool, Task_Func func, void *arg);
+
+/*wait until all submitted tasks are finished*/
+void thread_pool_wait(Thread_Pool *pool);
+
+/*stop all workers and release the pool, submitted tasks are finished first*/
+void thread_pool_destroy(Thread_Pool *pool);
+
+#endif
@@ -0,0 +1,85 @@
+#include "trace.h"
+
+/*initialize an empty trace, stride <= 1 keeps every change*/
+void trace_init(Trace *trace, int stride)
+{
+	trace->len = 0;
+	trace->capacity = 0;
+	trace->stride = stride > 1 ? stride : 1;
+	trace->points = NULL;
+}
+
+/*
+** record the best fitness of a generation. nothing is recorded if it did not change. a change within stride
+** generations of the one before the last point replaces the last point, so the latest value is always kept.
+*/
+void trace_add(Trace *trace, int generation, double eval_times, double fitness)
+{
+	Trace_Point *last = trace->len > 0 ? trace->points + trace->len - 1 : NULL;
+
+	if (last != NULL && last->fitness == fitness) {
+		return;
+	}
+
+	/*
+	** a second change in the same generation, or one which falls in the stride of the last point, moves that point.
+	*/
+	if (last != NULL && (last->generation == generation ||
+		(trace->len > 1 && generation - trace->points[trace->len - 2].generation < trace->stride))) {
+		last->generation = generation;
+		last->eval_times = eval_times;
+		last->fitness = fitness;
+		return;
+	}
+
+	if (trace->len == trace->capacity) {
+		int capacity = trace->capacity > 0 ? 2 * trace->capacity : 16;
+		Trace_Point *points = (Trace_Point *)realloc(trace->points, capacity * sizeof(Trace_Point));
+		if (points == NULL) {
+			printf("[TRACE.cpp--trace_add--ERROR] cannot allocate memory\n");
+			exit(EXIT_FAILURE);
+		}
+		trace->points = points;
+		trace->capacity = capacity;
+	}
+
+	trace->points[trace->len].generation = generation;
+	trace->points[trace->len].eval_times = eval_times;
+	trace->points[trace->len].fitness = fitness;
+	trace->len += 1;
+}
+
+/*remove all change points of a trace, its memory is kept for the next run*/
+void trace_clear(Trace *trace)
+{
+	trace->len = 0;
+}
+
+/*release the memory held by a trace*/
+void trace_free(Trace *trace)
+{
+	free(trace->points);
+	trace_init(trace, trace->stride);
+}
+
+/*best fitness at generation of a trace of len change points, 0 before the first point*/
+double trace_fitness_at(Trace_Point const *points, int len, int generation)
+{
+	int low = 0;
+	int high = len;
+
+	/*
+	** binary search for the first point after generation, the one before it holds the value.
+	*/
+	while (low < high) {
+		int middle = (low + high) / 2;
+		if (points[middle].generation <= generation) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+
+	return low > 0 ? points[low - 1].fitness : 0.0;
+}
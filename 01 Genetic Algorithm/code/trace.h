@@ -0,0 +1,46 @@
+#ifndef _HEADER_TRACE_H
+#define _HEADER_TRACE_H	1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_STRIDE	1	/*default downsampling of traces, at most one change point per this many generations. 1 keeps every change*/
+
+/*a change point of a convergence trace: from this generation on the best fitness is fitness*/
+typedef struct Trace_Point {
+	int generation;	/*generation of the change, 0 is the initial population*/
+	double eval_times;	/*evaluation times until the end of this generation*/
+	double fitness;	/*best fitness from this generation on*/
+} Trace_Point;
+
+/*
+** convergence trace of a run. only changes of the best fitness are recorded, so a trace grows with the
+** number of improvements instead of the number of generations.
+*/
+typedef struct Trace {
+	int len;	/*number of change points*/
+	int capacity;	/*number of change points points can hold*/
+	int stride;	/*downsampling, see TRACE_STRIDE*/
+	Trace_Point *points;
+} Trace;
+
+/*initialize an empty trace, stride <= 1 keeps every change*/
+void trace_init(Trace *trace, int stride);
+
+/*
+** record the best fitness of a generation. nothing is recorded if it did not change. a change within stride
+** generations of the one before the last point replaces the last point, so the latest value is always kept.
+*/
+void trace_add(Trace *trace, int generation, double eval_times, double fitness);
+
+/*remove all change points of a trace, its memory is kept for the next run*/
+void trace_clear(Trace *trace);
+
+/*release the memory held by a trace*/
+void trace_free(Trace *trace);
+
+/*best fitness at generation of a trace of len change points, 0 before the first point*/
+double trace_fitness_at(Trace_Point const *points, int len, int generation);
+
+#endif